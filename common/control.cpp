@@ -5,12 +5,15 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "control.h"
+#include "controlwatcher.h"
+#include "fileformat.h"
 #include "globals.h"
+#include "persistence.h"
 
-#include <KDirWatch>
-#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonDocument>
+#include <QSet>
 #include <QStringBuilder>
 
 #include <kscreen/config.h>
@@ -29,6 +32,7 @@
 #define vrrPolicyString                 QStringLiteral("vrrpolicy")
 #define rgbRangeString                  QStringLiteral("rgbrange")
 #define outputsString                   QStringLiteral("outputs")
+#define configString                    QStringLiteral("config")
 // clang-format on
 
 QString Control::s_dirName = QStringLiteral("control/");
@@ -43,17 +47,21 @@ void Control::activateWatcher()
     if (m_watcher) {
         return;
     }
-    m_watcher = new KDirWatch(this);
-    m_watcher->addFile(filePath());
-    connect(m_watcher, &KDirWatch::dirty, this, [this]() {
-        readFile();
+    const QString fileName = QFileInfo(filePath()).fileName();
+    m_watcher = ControlWatcher::forDirectory(dirPath());
+    m_watcher->addFile(fileName);
+    connect(m_watcher.data(), &ControlWatcher::filesChanged, this, [this, fileName](const QStringList &fileNames) {
+        if (!fileNames.contains(fileName)) {
+            return;
+        }
+        readData(m_watcher->data(fileName));
+        infoChanged();
         Q_EMIT changed();
     });
 }
 
-KDirWatch *Control::watcher() const
+void Control::infoChanged()
 {
-    return m_watcher;
 }
 
 bool Control::writeFile()
@@ -63,42 +71,43 @@ bool Control::writeFile()
 
     if (infoMap.isEmpty()) {
         // Nothing to write. Default control. Remove file if it exists.
-        QFile::remove(path);
-        return true;
-    }
-    if (!QDir().mkpath(dirPath())) {
-        // TODO: error message
-        return false;
+        ControlWatcher::fileWritten(path, QByteArray());
+        return Persistence::self()->remove(path);
     }
 
-    // write updated data to file
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly)) {
-        // TODO: logging category?
-        //        qCWarning(KSCREEN_COMMON) << "Failed to open config control file for writing! " << file.errorString();
-        return false;
-    }
-    file.write(QJsonDocument::fromVariant(infoMap).toJson());
-    //    qCDebug(KSCREEN_COMMON) << "Control saved on: " << file.fileName();
-    return true;
+    // write updated data to file, the directory is created on demand
+    const QByteArray data = FileFormat::encode(QJsonDocument::fromVariant(infoMap));
+    // Our own write is no change for anyone watching.
+    ControlWatcher::fileWritten(path, data);
+    return Persistence::self()->write(path, data);
 }
 
-QString Control::dirPath() const
+QString Control::rootDirPath()
 {
     return Globals::dirPath() % s_dirName;
 }
 
+QString Control::dirPath() const
+{
+    return rootDirPath();
+}
+
 void Control::readFile()
 {
     QFile file(filePath());
     if (file.open(QIODevice::ReadOnly)) {
         // This might not be reached, bus this is ok. The control file will
         // eventually be created on first write later on.
-        QJsonDocument parser;
-        m_info = parser.fromJson(file.readAll()).toVariant().toMap();
+        readData(file.readAll());
     }
 }
 
+void Control::readData(const QByteArray &data)
+{
+    // Empty data, i.e. a removed file, means defaults for everything.
+    m_info = FileFormat::decode(data).toVariant().toMap();
+}
+
 QString Control::filePathFromHash(const QString &hash) const
 {
     return dirPath() % hash;
@@ -128,54 +137,299 @@ Control::OutputRetention Control::convertVariantToOutputRetention(QVariant varia
     return OutputRetention::Undefined;
 }
 
+static QVariantMap metadata(const QString &outputName)
+{
+    QVariantMap metadata;
+    metadata[nameString] = outputName;
+    return metadata;
+}
+
+QVariantMap createOutputInfo(const QString &outputId, const QString &outputName)
+{
+    QVariantMap outputInfo;
+    outputInfo[idString] = outputId;
+    outputInfo[metadataString] = metadata(outputName);
+    return outputInfo;
+}
+
+template<typename T>
+static std::optional<T> takeValue(QVariantMap &info, const QString &key)
+{
+    const QVariant val = info.take(key);
+    if (!val.isValid() || !val.template canConvert<T>()) {
+        return std::nullopt;
+    }
+    return val.template value<T>();
+}
+
+template<typename T>
+static std::optional<T> takeEnumValue(QVariantMap &info, const QString &key)
+{
+    if (const auto val = takeValue<uint>(info, key)) {
+        return static_cast<T>(*val);
+    }
+    return std::nullopt;
+}
+
+ControlConfig::OutputInfo ControlConfig::OutputInfo::fromInfo(QVariantMap info)
+{
+    OutputInfo record;
+    record.id = info.take(idString).toString();
+    record.metadata = info.take(metadataString).toMap();
+    record.name = record.metadata[nameString].toString();
+    if (info.contains(retentionString)) {
+        record.retention = convertVariantToOutputRetention(info.take(retentionString));
+    }
+    record.scale = takeValue<qreal>(info, scaleString);
+    record.autoRotate = takeValue<bool>(info, autorotateString);
+    record.autoRotateOnlyInTabletMode = takeValue<bool>(info, autorotateTabletOnlyString);
+    record.replicateHash = takeValue<QString>(info, replicateHashString);
+    record.replicateName = takeValue<QString>(info, replicateNameString);
+    record.overscan = takeValue<uint>(info, overscanString);
+    record.vrrPolicy = takeEnumValue<KScreen::Output::VrrPolicy>(info, vrrPolicyString);
+    record.rgbRange = takeEnumValue<KScreen::Output::RgbRange>(info, rgbRangeString);
+    // Keep whatever we don't know about, so that it is written back unchanged.
+    record.other = info;
+    return record;
+}
+
+QVariantMap ControlConfig::OutputInfo::toInfo() const
+{
+    QVariantMap info = other;
+    info[idString] = id;
+    info[metadataString] = metadata;
+    if (retention) {
+        info[retentionString] = static_cast<int>(*retention);
+    }
+    if (scale) {
+        info[scaleString] = *scale;
+    }
+    if (autoRotate) {
+        info[autorotateString] = *autoRotate;
+    }
+    if (autoRotateOnlyInTabletMode) {
+        info[autorotateTabletOnlyString] = *autoRotateOnlyInTabletMode;
+    }
+    if (replicateHash) {
+        info[replicateHashString] = *replicateHash;
+    }
+    if (replicateName) {
+        info[replicateNameString] = *replicateName;
+    }
+    if (overscan) {
+        info[overscanString] = *overscan;
+    }
+    if (vrrPolicy) {
+        info[vrrPolicyString] = static_cast<uint32_t>(*vrrPolicy);
+    }
+    if (rgbRange) {
+        info[rgbRangeString] = static_cast<uint32_t>(*rgbRange);
+    }
+    return info;
+}
+
+QHash<QString, QWeakPointer<ControlConfig>> ControlConfig::s_sharedConfigs;
+
+QSharedPointer<ControlConfig> ControlConfig::forConfig(KScreen::ConfigPtr config)
+{
+    const QString hash = config->connectedOutputsHash();
+    QSharedPointer<ControlConfig> control = s_sharedConfigs.value(hash).toStrongRef();
+    if (control) {
+        return control;
+    }
+    for (auto it = s_sharedConfigs.begin(); it != s_sharedConfigs.end();) {
+        if (it->isNull()) {
+            it = s_sharedConfigs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // Users may let go of it in reaction to changed().
+    control.reset(new ControlConfig(config), &QObject::deleteLater);
+    control->activateWatcher();
+    s_sharedConfigs.insert(hash, control);
+    return control;
+}
+
 ControlConfig::ControlConfig(KScreen::ConfigPtr config, QObject *parent)
     : Control(parent)
     , m_config(config)
 {
     //    qDebug() << "Looking for control file:" << config->connectedOutputsHash();
     readFile();
+    readOutputRecords();
+
+    findDuplicateOutputIds();
+
+    const auto outputs = config->outputs();
+    for (const auto &output : outputs) {
+        addOutputControl(new ControlOutput(output, this));
+    }
+
+    // TODO: this is same in Output::readInOutputs of the daemon. Combine?
+
+    // TODO: connect to outputs added/removed signals and reevaluate duplicate ids
+    //       in case of such a change while object exists?
+}
+
+ControlConfig::ControlConfig(KScreen::ConfigPtr config, const ControlConfig &snapshotOf, QObject *parent)
+    : Control(parent)
+    , m_config(config)
+    , m_records(snapshotOf.m_records)
+    , m_recordIndex(snapshotOf.m_recordIndex)
+    , m_recordsChanged(snapshotOf.m_recordsChanged)
+{
+    info() = snapshotOf.constInfo();
+    findDuplicateOutputIds();
+
+    const auto outputs = config->outputs();
+    for (const auto &output : outputs) {
+        if (const auto *control = snapshotOf.getOutputControl(output->hashMd5(), output->name())) {
+            addOutputControl(new ControlOutput(output, control->constInfo(), this));
+        } else {
+            addOutputControl(new ControlOutput(output, this));
+        }
+    }
+}
 
-    // TODO: use a file watcher in case of changes to the control file while
-    //       object exists?
+QVariantMap ControlConfig::toVariantMap() const
+{
+    QVariantMap configInfo = constInfo();
+    if (m_recordsChanged) {
+        configInfo[outputsString] = outputRecordsInfo();
+    }
+    // Output control files are named after the output id.
+    QVariantMap outputsData;
+    for (auto *outputControl : m_outputsControls) {
+        outputsData[outputControl->id()] = outputControl->constInfo();
+    }
+
+    QVariantMap data;
+    data[configString] = configInfo;
+    data[outputsString] = outputsData;
+    return data;
+}
+
+void ControlConfig::setData(const QVariantMap &data)
+{
+    info() = data[configString].toMap();
+    readOutputRecords();
 
+    const QVariantMap outputsData = data[outputsString].toMap();
+    for (auto *outputControl : qAsConst(m_outputsControls)) {
+        outputControl->info() = outputsData[outputControl->id()].toMap();
+    }
+}
+
+void ControlConfig::findDuplicateOutputIds()
+{
     // As global outputs are indexed by a hash of their edid, which is not unique,
     // to be able to tell apart multiple identical outputs, these need special treatment
-    QStringList allIds;
-    const auto outputs = config->outputs();
+    QSet<QString> allIds;
+    const auto outputs = m_config->outputs();
     allIds.reserve(outputs.count());
     for (const KScreen::OutputPtr &output : outputs) {
         const auto outputId = output->hashMd5();
-        if (allIds.contains(outputId) && !m_duplicateOutputIds.contains(outputId)) {
-            m_duplicateOutputIds << outputId;
+        if (allIds.contains(outputId)) {
+            m_duplicateOutputIds.insert(outputId);
         }
-        allIds << outputId;
+        allIds.insert(outputId);
     }
+}
 
-    for (const auto &output : outputs) {
-        m_outputsControls << new ControlOutput(output, this);
+void ControlConfig::addOutputControl(ControlOutput *control)
+{
+    m_outputsControls << control;
+    m_outputControlIndex.insert(qMakePair(control->id(), control->name()), control);
+}
+
+void ControlConfig::readOutputRecords()
+{
+    m_records.clear();
+    m_recordIndex.clear();
+    m_recordsChanged = false;
+
+    const QVariantList outputsInfo = constInfo()[outputsString].toList();
+    m_records.reserve(outputsInfo.size());
+    for (const auto &variantInfo : outputsInfo) {
+        const OutputInfo record = OutputInfo::fromInfo(variantInfo.toMap());
+        if (record.id.isEmpty()) {
+            // Never matches an output, but is written back as it was.
+            m_records << record;
+            continue;
+        }
+        m_recordIndex[record.id] << m_records.size();
+        m_records << record;
     }
+}
 
-    // TODO: this is same in Output::readInOutputs of the daemon. Combine?
+QVariantList ControlConfig::outputRecordsInfo() const
+{
+    QVariantList outputsInfo;
+    outputsInfo.reserve(m_records.size());
+    for (const auto &record : m_records) {
+        outputsInfo << record.toInfo();
+    }
+    return outputsInfo;
+}
 
-    // TODO: connect to outputs added/removed signals and reevaluate duplicate ids
-    //       in case of such a change while object exists?
+void ControlConfig::writeOutputRecords()
+{
+    if (!m_recordsChanged) {
+        return;
+    }
+    info()[outputsString] = outputRecordsInfo();
+    m_recordsChanged = false;
+}
+
+void ControlConfig::infoChanged()
+{
+    readOutputRecords();
 }
 
 void ControlConfig::activateWatcher()
 {
-    if (watcher()) {
-        // Watcher was already activated.
+    Control::activateWatcher();
+    if (m_outputsWatcher || m_outputsControls.isEmpty()) {
+        // Watcher was already activated or there is nothing to watch.
         return;
     }
+    m_outputsWatcher = ControlWatcher::forDirectory(m_outputsControls.constFirst()->dirPath());
+    for (auto *output : qAsConst(m_outputsControls)) {
+        m_outputsWatcher->addFile(output->id());
+    }
+    connect(m_outputsWatcher.data(), &ControlWatcher::filesChanged, this, &ControlConfig::outputFilesChanged);
+}
+
+void ControlConfig::outputFilesChanged(const QStringList &fileNames)
+{
+    QStringList outputIds;
     for (auto *output : qAsConst(m_outputsControls)) {
-        output->activateWatcher();
-        connect(output, &ControlOutput::changed, this, &ControlConfig::changed);
+        // Output control files are named after the output id.
+        const QString outputId = output->id();
+        if (!fileNames.contains(outputId)) {
+            continue;
+        }
+        output->readData(m_outputsWatcher->data(outputId));
+        if (!outputIds.contains(outputId)) {
+            outputIds << outputId;
+        }
+    }
+    if (outputIds.isEmpty()) {
+        return;
     }
+    Q_EMIT outputsChanged(outputIds);
+    Q_EMIT changed();
+}
+
+QString ControlConfig::configsDirPath()
+{
+    return rootDirPath() % QStringLiteral("configs/");
 }
 
 QString ControlConfig::dirPath() const
 {
-    return Control::dirPath() % QStringLiteral("configs/");
+    return configsDirPath();
 }
 
 QString ControlConfig::filePath() const
@@ -188,6 +442,8 @@ QString ControlConfig::filePath() const
 
 bool ControlConfig::writeFile()
 {
+    writeOutputRecords();
+
     bool success = true;
     for (auto *outputControl : qAsConst(m_outputsControls)) {
         if (getOutputRetention(outputControl->id(), outputControl->name()) == OutputRetention::Individual) {
@@ -198,27 +454,38 @@ bool ControlConfig::writeFile()
     return success && Control::writeFile();
 }
 
-bool ControlConfig::infoIsOutput(const QVariantMap &info, const QString &outputId, const QString &outputName) const
+const ControlConfig::OutputInfo *ControlConfig::record(const QString &outputId, const QString &outputName) const
 {
-    const QString outputIdInfo = info[idString].toString();
-    if (outputIdInfo.isEmpty()) {
-        return false;
+    const auto it = m_recordIndex.constFind(outputId);
+    if (it == m_recordIndex.constEnd()) {
+        return nullptr;
     }
-    if (outputId != outputIdInfo) {
-        return false;
+    // We may have identical outputs connected, these will have the same id in the config
+    // in order to find the right one, also check the output's name (usually the connector)
+    const bool checkName = !outputName.isEmpty() && m_duplicateOutputIds.contains(outputId);
+    for (const int index : *it) {
+        const OutputInfo &record = m_records.at(index);
+        if (!checkName || record.name == outputName) {
+            return &record;
+        }
     }
+    return nullptr;
+}
 
-    if (!outputName.isEmpty() && m_duplicateOutputIds.contains(outputId)) {
-        // We may have identical outputs connected, these will have the same id in the config
-        // in order to find the right one, also check the output's name (usually the connector)
-        const auto metadata = info[metadataString].toMap();
-        const auto outputNameInfo = metadata[nameString].toString();
-        if (outputName != outputNameInfo) {
-            // was a duplicate id, but info not for this output
-            return false;
-        }
+ControlConfig::OutputInfo &ControlConfig::recordForWriting(const QString &outputId, const QString &outputName)
+{
+    m_recordsChanged = true;
+    if (const auto *existing = record(outputId, outputName)) {
+        return m_records[existing - m_records.constData()];
     }
-    return true;
+    // no entry yet, create one
+    OutputInfo newRecord;
+    newRecord.id = outputId;
+    newRecord.name = outputName;
+    newRecord.metadata = metadata(outputName);
+    m_recordIndex[outputId] << m_records.size();
+    m_records << newRecord;
+    return m_records.last();
 }
 
 Control::OutputRetention ControlConfig::getOutputRetention(const KScreen::OutputPtr &output) const
@@ -228,33 +495,13 @@ Control::OutputRetention ControlConfig::getOutputRetention(const KScreen::Output
 
 Control::OutputRetention ControlConfig::getOutputRetention(const QString &outputId, const QString &outputName) const
 {
-    const QVariantList outputsInfo = getOutputs();
-    for (const auto &variantInfo : outputsInfo) {
-        const QVariantMap info = variantInfo.toMap();
-        if (!infoIsOutput(info, outputId, outputName)) {
-            continue;
-        }
-        return convertVariantToOutputRetention(info[retentionString]);
+    if (const auto *info = record(outputId, outputName)) {
+        return info->retention.value_or(OutputRetention::Undefined);
     }
     // info for output not found
     return OutputRetention::Undefined;
 }
 
-static QVariantMap metadata(const QString &outputName)
-{
-    QVariantMap metadata;
-    metadata[nameString] = outputName;
-    return metadata;
-}
-
-QVariantMap createOutputInfo(const QString &outputId, const QString &outputName)
-{
-    QVariantMap outputInfo;
-    outputInfo[idString] = outputId;
-    outputInfo[metadataString] = metadata(outputName);
-    return outputInfo;
-}
-
 void ControlConfig::setOutputRetention(const KScreen::OutputPtr &output, OutputRetention value)
 {
     setOutputRetention(output->hashMd5(), output->name(), value);
@@ -262,47 +509,17 @@ void ControlConfig::setOutputRetention(const KScreen::OutputPtr &output, OutputR
 
 void ControlConfig::setOutputRetention(const QString &outputId, const QString &outputName, OutputRetention value)
 {
-    QList<QVariant>::iterator it;
-    QVariantList outputsInfo = getOutputs();
-
-    for (it = outputsInfo.begin(); it != outputsInfo.end(); ++it) {
-        QVariantMap outputInfo = (*it).toMap();
-        if (!infoIsOutput(outputInfo, outputId, outputName)) {
-            continue;
-        }
-        outputInfo[retentionString] = (int)value;
-        *it = outputInfo;
-        setOutputs(outputsInfo);
-        return;
-    }
-    // no entry yet, create one
-    auto outputInfo = createOutputInfo(outputId, outputName);
-    outputInfo[retentionString] = (int)value;
-
-    outputsInfo << outputInfo;
-    setOutputs(outputsInfo);
+    recordForWriting(outputId, outputName).retention = value;
 }
 
 template<typename T, typename F>
-T ControlConfig::get(const KScreen::OutputPtr &output, const QString &name, F globalRetentionFunc, T defaultValue) const
+T ControlConfig::get(const KScreen::OutputPtr &output, std::optional<T> OutputInfo::*field, F globalRetentionFunc, T defaultValue) const
 {
     const auto &outputId = output->hashMd5();
     const auto &outputName = output->name();
-    const auto retention = getOutputRetention(outputId, outputName);
-    if (retention == OutputRetention::Individual) {
-        const QVariantList outputsInfo = getOutputs();
-        for (const auto &variantInfo : outputsInfo) {
-            const QVariantMap info = variantInfo.toMap();
-            if (!infoIsOutput(info, outputId, outputName)) {
-                continue;
-            }
-            const auto val = info[name];
-            if (val.template canConvert<T>()) {
-                return val.template value<T>();
-            } else {
-                return defaultValue;
-            }
-        }
+    const auto *info = record(outputId, outputName);
+    if (info && info->retention == OutputRetention::Individual) {
+        return (info->*field).value_or(defaultValue);
     }
     // Retention is global or info for output not in config control file.
     if (auto *outputControl = getOutputControl(outputId, outputName)) {
@@ -313,33 +530,12 @@ T ControlConfig::get(const KScreen::OutputPtr &output, const QString &name, F gl
     return defaultValue;
 }
 
-template<typename T, typename F, typename V>
-void ControlConfig::set(const KScreen::OutputPtr &output, const QString &name, F globalRetentionFunc, V value)
+template<typename T, typename F>
+void ControlConfig::set(const KScreen::OutputPtr &output, std::optional<T> OutputInfo::*field, F globalRetentionFunc, T value)
 {
     const auto &outputId = output->hashMd5();
     const auto &outputName = output->name();
-    QList<QVariant>::iterator it;
-    QVariantList outputsInfo = getOutputs();
-
-    for (it = outputsInfo.begin(); it != outputsInfo.end(); ++it) {
-        QVariantMap outputInfo = (*it).toMap();
-        if (!infoIsOutput(outputInfo, outputId, outputName)) {
-            continue;
-        }
-        outputInfo[name] = static_cast<T>(value);
-        *it = outputInfo;
-        setOutputs(outputsInfo);
-        if (auto *control = getOutputControl(outputId, outputName)) {
-            (control->*globalRetentionFunc)(value);
-        }
-        return;
-    }
-    // no entry yet, create one
-    auto outputInfo = createOutputInfo(outputId, outputName);
-    outputInfo[name] = static_cast<T>(value);
-
-    outputsInfo << outputInfo;
-    setOutputs(outputsInfo);
+    recordForWriting(outputId, outputName).*field = value;
     if (auto *control = getOutputControl(outputId, outputName)) {
         (control->*globalRetentionFunc)(value);
     }
@@ -347,141 +543,105 @@ void ControlConfig::set(const KScreen::OutputPtr &output, const QString &name, F
 
 qreal ControlConfig::getScale(const KScreen::OutputPtr &output) const
 {
-    return get(output, scaleString, &ControlOutput::getScale, -1.0);
+    return get(output, &OutputInfo::scale, &ControlOutput::getScale, -1.0);
 }
 
 void ControlConfig::setScale(const KScreen::OutputPtr &output, qreal value)
 {
-    set<qreal>(output, scaleString, &ControlOutput::setScale, value);
+    set(output, &OutputInfo::scale, &ControlOutput::setScale, value);
 }
 
 bool ControlConfig::getAutoRotate(const KScreen::OutputPtr &output) const
 {
-    return get(output, autorotateString, &ControlOutput::getAutoRotate, true);
+    return get(output, &OutputInfo::autoRotate, &ControlOutput::getAutoRotate, true);
 }
 
 void ControlConfig::setAutoRotate(const KScreen::OutputPtr &output, bool value)
 {
-    set<bool>(output, autorotateString, &ControlOutput::setAutoRotate, value);
+    set(output, &OutputInfo::autoRotate, &ControlOutput::setAutoRotate, value);
 }
 
 bool ControlConfig::getAutoRotateOnlyInTabletMode(const KScreen::OutputPtr &output) const
 {
-    return get(output, autorotateTabletOnlyString, &ControlOutput::getAutoRotateOnlyInTabletMode, true);
+    return get(output, &OutputInfo::autoRotateOnlyInTabletMode, &ControlOutput::getAutoRotateOnlyInTabletMode, true);
 }
 
 void ControlConfig::setAutoRotateOnlyInTabletMode(const KScreen::OutputPtr &output, bool value)
 {
-    set<bool>(output, autorotateTabletOnlyString, &ControlOutput::setAutoRotateOnlyInTabletMode, value);
+    set(output, &OutputInfo::autoRotateOnlyInTabletMode, &ControlOutput::setAutoRotateOnlyInTabletMode, value);
 }
 
 KScreen::OutputPtr ControlConfig::getReplicationSource(const KScreen::OutputPtr &output) const
 {
-    const QVariantList outputsInfo = getOutputs();
-    for (const auto &variantInfo : outputsInfo) {
-        const QVariantMap info = variantInfo.toMap();
-        if (!infoIsOutput(info, output->hashMd5(), output->name())) {
-            continue;
-        }
-        const QString sourceHash = info[replicateHashString].toString();
-        const QString sourceName = info[replicateNameString].toString();
+    return getReplicationSource(m_config, output);
+}
 
-        if (sourceHash.isEmpty() && sourceName.isEmpty()) {
-            // Common case when the replication source has been unset.
-            return nullptr;
-        }
+KScreen::OutputPtr ControlConfig::getReplicationSource(const KScreen::ConfigPtr &config, const KScreen::OutputPtr &output) const
+{
+    const auto *info = record(output->hashMd5(), output->name());
+    if (!info) {
+        // Info for output not found.
+        return nullptr;
+    }
+    const QString sourceHash = info->replicateHash.value_or(QString());
+    const QString sourceName = info->replicateName.value_or(QString());
 
-        const auto outputs = m_config->outputs();
-        for (const auto &output : outputs) {
-            if (output->hashMd5() == sourceHash && output->name() == sourceName) {
-                return output;
-            }
-        }
-        // No match.
+    if (sourceHash.isEmpty() && sourceName.isEmpty()) {
+        // Common case when the replication source has been unset.
         return nullptr;
     }
-    // Info for output not found.
+
+    const auto outputs = config->outputs();
+    for (const auto &output : outputs) {
+        if (output->hashMd5() == sourceHash && output->name() == sourceName) {
+            return output;
+        }
+    }
+    // No match.
     return nullptr;
 }
 
 void ControlConfig::setReplicationSource(const KScreen::OutputPtr &output, const KScreen::OutputPtr &source)
 {
-    QList<QVariant>::iterator it;
-    QVariantList outputsInfo = getOutputs();
-    const QString sourceHash = source ? source->hashMd5() : QString();
-    const QString sourceName = source ? source->name() : QString();
-
-    for (it = outputsInfo.begin(); it != outputsInfo.end(); ++it) {
-        QVariantMap outputInfo = (*it).toMap();
-        if (!infoIsOutput(outputInfo, output->hashMd5(), output->name())) {
-            continue;
-        }
-        outputInfo[replicateHashString] = sourceHash;
-        outputInfo[replicateNameString] = sourceName;
-        *it = outputInfo;
-        setOutputs(outputsInfo);
-        // TODO: shall we set this information also as new global value (like with auto-rotate)?
-        return;
-    }
-    // no entry yet, create one
-    auto outputInfo = createOutputInfo(output->hashMd5(), output->name());
-    outputInfo[replicateHashString] = sourceHash;
-    outputInfo[replicateNameString] = sourceName;
-
-    outputsInfo << outputInfo;
-    setOutputs(outputsInfo);
+    OutputInfo &info = recordForWriting(output->hashMd5(), output->name());
+    info.replicateHash = source ? source->hashMd5() : QString();
+    info.replicateName = source ? source->name() : QString();
     // TODO: shall we set this information also as new global value (like with auto-rotate)?
 }
 
 uint32_t ControlConfig::getOverscan(const KScreen::OutputPtr &output) const
 {
-    return get(output, overscanString, &ControlOutput::overscan, 0);
+    return get(output, &OutputInfo::overscan, &ControlOutput::overscan, 0u);
 }
 
 void ControlConfig::setOverscan(const KScreen::OutputPtr &output, const uint32_t value)
 {
-    set<uint32_t>(output, overscanString, &ControlOutput::setOverscan, value);
+    set(output, &OutputInfo::overscan, &ControlOutput::setOverscan, value);
 }
 
 KScreen::Output::VrrPolicy ControlConfig::getVrrPolicy(const KScreen::OutputPtr &output) const
 {
-    return get(output, vrrPolicyString, &ControlOutput::vrrPolicy, KScreen::Output::VrrPolicy::Automatic);
+    return get(output, &OutputInfo::vrrPolicy, &ControlOutput::vrrPolicy, KScreen::Output::VrrPolicy::Automatic);
 }
 
 void ControlConfig::setVrrPolicy(const KScreen::OutputPtr &output, const KScreen::Output::VrrPolicy value)
 {
-    set<uint32_t>(output, vrrPolicyString, &ControlOutput::setVrrPolicy, value);
+    set(output, &OutputInfo::vrrPolicy, &ControlOutput::setVrrPolicy, value);
 }
 
 KScreen::Output::RgbRange ControlConfig::getRgbRange(const KScreen::OutputPtr &output) const
 {
-    return get(output, rgbRangeString, &ControlOutput::rgbRange, KScreen::Output::RgbRange::Automatic);
+    return get(output, &OutputInfo::rgbRange, &ControlOutput::rgbRange, KScreen::Output::RgbRange::Automatic);
 }
 
 void ControlConfig::setRgbRange(const KScreen::OutputPtr &output, const KScreen::Output::RgbRange value)
 {
-    set<uint32_t>(output, rgbRangeString, &ControlOutput::setRgbRange, value);
-}
-
-QVariantList ControlConfig::getOutputs() const
-{
-    return constInfo()[outputsString].toList();
-}
-
-void ControlConfig::setOutputs(QVariantList outputsInfo)
-{
-    auto &infoMap = info();
-    infoMap[outputsString] = outputsInfo;
+    set(output, &OutputInfo::rgbRange, &ControlOutput::setRgbRange, value);
 }
 
 ControlOutput *ControlConfig::getOutputControl(const QString &outputId, const QString &outputName) const
 {
-    for (auto *control : m_outputsControls) {
-        if (control->id() == outputId && control->name() == outputName) {
-            return control;
-        }
-    }
-    return nullptr;
+    return m_outputControlIndex.value(qMakePair(outputId, outputName));
 }
 
 ControlOutput::ControlOutput(KScreen::OutputPtr output, QObject *parent)
@@ -491,6 +651,13 @@ ControlOutput::ControlOutput(KScreen::OutputPtr output, QObject *parent)
     readFile();
 }
 
+ControlOutput::ControlOutput(KScreen::OutputPtr output, const QVariantMap &info, QObject *parent)
+    : Control(parent)
+    , m_output(output)
+{
+    this->info() = info;
+}
+
 QString ControlOutput::id() const
 {
     return m_output->hashMd5();
@@ -9,11 +9,17 @@
 #include <kscreen/output.h>
 #include <kscreen/types.h>
 
+#include <QHash>
 #include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QSharedPointer>
 #include <QVariantMap>
 #include <QVector>
 
-class KDirWatch;
+#include <optional>
+
+class ControlWatcher;
 
 class Control : public QObject
 {
@@ -37,20 +43,26 @@ Q_SIGNALS:
     void changed();
 
 protected:
+    /**
+     * Called when the watcher replaced the data with what was read from the file.
+     */
+    virtual void infoChanged();
+
+    static QString rootDirPath();
     virtual QString dirPath() const;
     virtual QString filePath() const = 0;
     QString filePathFromHash(const QString &hash) const;
     void readFile();
+    void readData(const QByteArray &data);
     QVariantMap &info();
     const QVariantMap &constInfo() const;
-    KDirWatch *watcher() const;
 
     static OutputRetention convertVariantToOutputRetention(QVariant variant);
 
 private:
     static QString s_dirName;
     QVariantMap m_info;
-    KDirWatch *m_watcher = nullptr;
+    QSharedPointer<ControlWatcher> m_watcher;
 };
 
 class ControlOutput;
@@ -60,6 +72,26 @@ class ControlConfig : public Control
     Q_OBJECT
 public:
     explicit ControlConfig(KScreen::ConfigPtr config, QObject *parent = nullptr);
+    /**
+     * Creates a copy of @p snapshotOf for @p config, which must have the same outputs, without
+     * reading the control files again.
+     */
+    ControlConfig(KScreen::ConfigPtr config, const ControlConfig &snapshotOf, QObject *parent = nullptr);
+
+    /**
+     * The control of all configs with the connected outputs of @p config, shared by everyone
+     * using one at the same time. It watches its files to stay up to date while it is shared.
+     */
+    static QSharedPointer<ControlConfig> forConfig(KScreen::ConfigPtr config);
+
+    /**
+     * The control data of the config and all its outputs, for handing them to another process.
+     */
+    QVariantMap toVariantMap() const;
+    /**
+     * Replaces the control data with @p data as returned by toVariantMap().
+     */
+    void setData(const QVariantMap &data);
 
     OutputRetention getOutputRetention(const KScreen::OutputPtr &output) const;
     OutputRetention getOutputRetention(const QString &outputId, const QString &outputName) const;
@@ -76,6 +108,11 @@ public:
     void setAutoRotateOnlyInTabletMode(const KScreen::OutputPtr &output, bool value);
 
     KScreen::OutputPtr getReplicationSource(const KScreen::OutputPtr &output) const;
+    /**
+     * The replication source of @p output among the outputs of @p config, for when the control
+     * was created for another config with the same outputs.
+     */
+    KScreen::OutputPtr getReplicationSource(const KScreen::ConfigPtr &config, const KScreen::OutputPtr &output) const;
     void setReplicationSource(const KScreen::OutputPtr &output, const KScreen::OutputPtr &source);
 
     uint32_t getOverscan(const KScreen::OutputPtr &output) const;
@@ -87,26 +124,78 @@ public:
     KScreen::Output::RgbRange getRgbRange(const KScreen::OutputPtr &output) const;
     void setRgbRange(const KScreen::OutputPtr &output, const KScreen::Output::RgbRange value);
 
+    /**
+     * The directory of the control files of all configs, named by connectedOutputsHash().
+     */
+    static QString configsDirPath();
+
     QString dirPath() const override;
     QString filePath() const override;
 
     bool writeFile() override;
+    /**
+     * Watches the control files of all outputs. Changes are reported once per batch of file
+     * events through outputsChanged() and changed().
+     */
     void activateWatcher() override;
 
+Q_SIGNALS:
+    void outputsChanged(const QStringList &outputIds);
+
+protected:
+    void infoChanged() override;
+
 private:
-    QVariantList getOutputs() const;
-    void setOutputs(QVariantList outputsInfo);
-    bool infoIsOutput(const QVariantMap &info, const QString &outputId, const QString &outputName) const;
+    /**
+     * The entry of one output in the control file. Kept as typed values and only turned back
+     * into a variant map when the file is written.
+     */
+    struct OutputInfo {
+        QString id;
+        QString name;
+        QVariantMap metadata;
+        std::optional<OutputRetention> retention;
+        std::optional<qreal> scale;
+        std::optional<bool> autoRotate;
+        std::optional<bool> autoRotateOnlyInTabletMode;
+        std::optional<QString> replicateHash;
+        std::optional<QString> replicateName;
+        std::optional<uint32_t> overscan;
+        std::optional<KScreen::Output::VrrPolicy> vrrPolicy;
+        std::optional<KScreen::Output::RgbRange> rgbRange;
+        // Entries we don't know about
+        QVariantMap other;
+
+        static OutputInfo fromInfo(QVariantMap info);
+        QVariantMap toInfo() const;
+    };
+
+    void outputFilesChanged(const QStringList &fileNames);
+    void findDuplicateOutputIds();
+    void addOutputControl(ControlOutput *control);
+    void readOutputRecords();
+    QVariantList outputRecordsInfo() const;
+    void writeOutputRecords();
+    const OutputInfo *record(const QString &outputId, const QString &outputName) const;
+    OutputInfo &recordForWriting(const QString &outputId, const QString &outputName);
     ControlOutput *getOutputControl(const QString &outputId, const QString &outputName) const;
 
     template<typename T, typename F>
-    T get(const KScreen::OutputPtr &output, const QString &name, F globalRetentionFunc, T defaultValue) const;
-    template<typename T, typename F, typename V>
-    void set(const KScreen::OutputPtr &output, const QString &name, F globalRetentionFunc, V value);
+    T get(const KScreen::OutputPtr &output, std::optional<T> OutputInfo::*field, F globalRetentionFunc, T defaultValue) const;
+    template<typename T, typename F>
+    void set(const KScreen::OutputPtr &output, std::optional<T> OutputInfo::*field, F globalRetentionFunc, T value);
 
     KScreen::ConfigPtr m_config;
-    QStringList m_duplicateOutputIds;
+    QSet<QString> m_duplicateOutputIds;
     QVector<ControlOutput *> m_outputsControls;
+    QHash<QPair<QString, QString>, ControlOutput *> m_outputControlIndex;
+    QSharedPointer<ControlWatcher> m_outputsWatcher;
+    // In the order of the file, indexed by output id
+    QVector<OutputInfo> m_records;
+    QHash<QString, QVector<int>> m_recordIndex;
+    bool m_recordsChanged = false;
+
+    static QHash<QString, QWeakPointer<ControlConfig>> s_sharedConfigs;
 };
 
 class ControlOutput : public Control
@@ -114,6 +203,7 @@ class ControlOutput : public Control
     Q_OBJECT
 public:
     explicit ControlOutput(KScreen::OutputPtr output, QObject *parent = nullptr);
+    ControlOutput(KScreen::OutputPtr output, const QVariantMap &info, QObject *parent = nullptr);
 
     QString id() const;
     QString name() const;
@@ -142,6 +232,8 @@ public:
     QString filePath() const override;
 
 private:
+    friend class ControlConfig;
+
     KScreen::OutputPtr m_output;
 };
 
@@ -0,0 +1,131 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "controlwatcher.h"
+
+#include <KDirWatch>
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringBuilder>
+
+// Editors and our own atomic writes cause several events per change.
+static const int s_compressInterval = 50;
+
+QHash<QString, QWeakPointer<ControlWatcher>> ControlWatcher::s_watchers;
+
+QSharedPointer<ControlWatcher> ControlWatcher::forDirectory(const QString &dirPath)
+{
+    QSharedPointer<ControlWatcher> watcher = s_watchers.value(dirPath).toStrongRef();
+    if (watcher) {
+        return watcher;
+    }
+    for (auto it = s_watchers.begin(); it != s_watchers.end();) {
+        if (it->isNull()) {
+            it = s_watchers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // Users may let go of it in reaction to filesChanged().
+    watcher.reset(new ControlWatcher(dirPath), &QObject::deleteLater);
+    s_watchers.insert(dirPath, watcher);
+    return watcher;
+}
+
+ControlWatcher::ControlWatcher(const QString &dirPath)
+    : QObject()
+    , m_dirPath(dirPath)
+    , m_watcher(new KDirWatch(this))
+{
+    m_compressTimer.setSingleShot(true);
+    m_compressTimer.setInterval(s_compressInterval);
+    connect(&m_compressTimer, &QTimer::timeout, this, &ControlWatcher::processEvents);
+
+    m_watcher->addDir(m_dirPath, KDirWatch::WatchFiles);
+    connect(m_watcher, &KDirWatch::dirty, this, &ControlWatcher::fileEvent);
+    connect(m_watcher, &KDirWatch::created, this, &ControlWatcher::fileEvent);
+    connect(m_watcher, &KDirWatch::deleted, this, &ControlWatcher::fileEvent);
+}
+
+void ControlWatcher::fileWritten(const QString &filePath, const QByteArray &data)
+{
+    const int separator = filePath.lastIndexOf(QLatin1Char('/')) + 1;
+    const auto watcherIt = s_watchers.find(filePath.left(separator));
+    if (watcherIt == s_watchers.end()) {
+        return;
+    }
+    const QSharedPointer<ControlWatcher> watcher = watcherIt->toStrongRef();
+    if (!watcher) {
+        s_watchers.erase(watcherIt);
+        return;
+    }
+    const auto it = watcher->m_files.find(filePath.mid(separator));
+    if (it == watcher->m_files.end()) {
+        return;
+    }
+    it->data = data;
+    it->hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+}
+
+void ControlWatcher::addFile(const QString &fileName)
+{
+    if (!m_files.contains(fileName)) {
+        readFile(fileName);
+    }
+}
+
+QByteArray ControlWatcher::data(const QString &fileName) const
+{
+    return m_files.value(fileName).data;
+}
+
+void ControlWatcher::fileEvent(const QString &path)
+{
+    const QFileInfo fileInfo(path);
+    if (fileInfo.isDir()) {
+        // The directory itself was created or removed, recheck everything.
+        for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+            m_pendingFileNames.insert(it.key());
+        }
+    } else if (m_files.contains(fileInfo.fileName())) {
+        m_pendingFileNames.insert(fileInfo.fileName());
+    } else {
+        return;
+    }
+    m_compressTimer.start();
+}
+
+void ControlWatcher::processEvents()
+{
+    QStringList changedFileNames;
+    for (const QString &fileName : qAsConst(m_pendingFileNames)) {
+        if (readFile(fileName)) {
+            changedFileNames << fileName;
+        }
+    }
+    m_pendingFileNames.clear();
+    if (!changedFileNames.isEmpty()) {
+        Q_EMIT filesChanged(changedFileNames);
+    }
+}
+
+bool ControlWatcher::readFile(const QString &fileName)
+{
+    File file;
+    QFile diskFile(m_dirPath % fileName);
+    if (diskFile.open(QIODevice::ReadOnly)) {
+        file.data = diskFile.readAll();
+    }
+    file.hash = QCryptographicHash::hash(file.data, QCryptographicHash::Md5);
+
+    const auto it = m_files.constFind(fileName);
+    if (it != m_files.constEnd() && it->hash == file.hash) {
+        return false;
+    }
+    m_files.insert(fileName, file);
+    return true;
+}
@@ -0,0 +1,68 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QTimer>
+
+class KDirWatch;
+
+/**
+ * Watches one control directory for all Control objects interested in its files.
+ *
+ * Change events are collected for a short while, then the registered files among them are read
+ * and compared by content hash with what was seen before. Only files whose content really changed
+ * are reported, all at once through filesChanged().
+ */
+class ControlWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @returns the watcher shared by everyone watching @p dirPath, which lives as long as someone
+     *          holds on to it
+     */
+    static QSharedPointer<ControlWatcher> forDirectory(const QString &dirPath);
+
+    /**
+     * Tells the watcher of the directory of @p filePath, if any, that @p data is being written
+     * to it by this process, so that this is not reported as a change.
+     */
+    static void fileWritten(const QString &filePath, const QByteArray &data);
+
+    void addFile(const QString &fileName);
+    /**
+     * The content of @p fileName as last read, empty if it does not exist.
+     */
+    QByteArray data(const QString &fileName) const;
+
+Q_SIGNALS:
+    void filesChanged(const QStringList &fileNames);
+
+private:
+    explicit ControlWatcher(const QString &dirPath);
+
+    void fileEvent(const QString &path);
+    void processEvents();
+    bool readFile(const QString &fileName);
+
+    struct File {
+        QByteArray data;
+        QByteArray hash;
+    };
+    QString m_dirPath;
+    KDirWatch *m_watcher;
+    QTimer m_compressTimer;
+    QHash<QString, File> m_files;
+    QSet<QString> m_pendingFileNames;
+
+    static QHash<QString, QWeakPointer<ControlWatcher>> s_watchers;
+};
@@ -0,0 +1,61 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "fileformat.h"
+
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonObject>
+
+namespace FileFormat
+{
+// Encoding of the self-describe tag 55799, which can not start a JSON text.
+static const QByteArray s_cborSignature = QByteArrayLiteral("\xd9\xd9\xf7");
+
+Format writeFormat()
+{
+    static const Format format = qgetenv("KSCREEN_FILE_FORMAT") == QByteArrayLiteral("cbor") ? Format::Cbor : Format::Json;
+    return format;
+}
+
+Format detect(const QByteArray &data)
+{
+    return data.startsWith(s_cborSignature) ? Format::Cbor : Format::Json;
+}
+
+QByteArray encode(const QJsonDocument &document, Format format)
+{
+    if (format == Format::Json) {
+        return document.toJson();
+    }
+    const QCborValue value = document.isArray() ? QCborValue(QCborArray::fromJsonArray(document.array())) //
+                                                : QCborValue(QCborMap::fromJsonObject(document.object()));
+    return QCborValue(QCborKnownTags::Signature, value).toCbor();
+}
+
+QJsonDocument decode(const QByteArray &data)
+{
+    if (detect(data) == Format::Json) {
+        return QJsonDocument::fromJson(data);
+    }
+    QCborParserError error;
+    const QCborValue value = QCborValue::fromCbor(data, &error);
+    if (error.error != QCborError::NoError) {
+        qWarning() << "Failed to parse CBOR data:" << error.errorString();
+        return QJsonDocument();
+    }
+    const QCborValue content = value.isTag() ? value.taggedValue() : value;
+    if (content.isArray()) {
+        return QJsonDocument(content.toArray().toJsonArray());
+    }
+    if (content.isMap()) {
+        return QJsonDocument(content.toMap().toJsonObject());
+    }
+    return QJsonDocument();
+}
+}
@@ -0,0 +1,44 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QJsonDocument>
+
+/**
+ * Encoding of the files kscreen persists.
+ *
+ * Files are written as indented JSON by default. With KSCREEN_FILE_FORMAT=cbor set in the
+ * environment they are written as CBOR instead, starting with the self-describe tag so that
+ * readers can tell the formats apart. Readers always accept both, which lets existing
+ * installations migrate lazily as files get rewritten.
+ */
+namespace FileFormat
+{
+enum class Format {
+    Json,
+    Cbor,
+};
+
+/**
+ * The format newly written files are encoded in.
+ */
+Format writeFormat();
+
+Format detect(const QByteArray &data);
+
+QByteArray encode(const QJsonDocument &document, Format format);
+inline QByteArray encode(const QJsonDocument &document)
+{
+    return encode(document, writeFormat());
+}
+
+/**
+ * Decodes @p data in either format.
+ * @returns a null document if @p data could not be parsed
+ */
+QJsonDocument decode(const QByteArray &data);
+}
@@ -0,0 +1,160 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "flightrecorder.h"
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <atomic>
+#include <chrono>
+
+static const QString s_dbusPath = QStringLiteral("/org/kde/KScreen/FlightRecorder");
+
+namespace
+{
+const quint64 s_capacity = 2048;
+
+struct Entry {
+    // Odd while being written, otherwise twice the index of the entry plus two.
+    std::atomic<quint64> sequence{0};
+    std::atomic<const char *> category{nullptr};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<qint64> startNs{0};
+    // -1 for instant events
+    std::atomic<qint64> durationNs{-1};
+    std::atomic<quint32> threadId{0};
+};
+
+Entry s_entries[s_capacity];
+std::atomic<quint64> s_nextIndex{0};
+std::atomic<quint32> s_nextThreadId{1};
+
+quint32 currentThreadId()
+{
+    thread_local const quint32 threadId = s_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return threadId;
+}
+
+void record(const char *category, const char *name, qint64 startNs, qint64 durationNs)
+{
+    const quint64 index = s_nextIndex.fetch_add(1, std::memory_order_relaxed);
+    Entry &entry = s_entries[index % s_capacity];
+    entry.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.category.store(category, std::memory_order_relaxed);
+    entry.name.store(name, std::memory_order_relaxed);
+    entry.startNs.store(startNs, std::memory_order_relaxed);
+    entry.durationNs.store(durationNs, std::memory_order_relaxed);
+    entry.threadId.store(currentThreadId(), std::memory_order_relaxed);
+    entry.sequence.store(2 * index + 2, std::memory_order_release);
+}
+}
+
+FlightRecorder::Span::Span(const char *category, const char *name)
+    : m_category(category)
+    , m_name(name)
+    , m_startNs(now())
+{
+}
+
+FlightRecorder::Span::~Span()
+{
+    complete(m_category, m_name, m_startNs);
+}
+
+qint64 FlightRecorder::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FlightRecorder::instant(const char *category, const char *name)
+{
+    record(category, name, now(), -1);
+}
+
+void FlightRecorder::complete(const char *category, const char *name, qint64 startNs)
+{
+    record(category, name, startNs, now() - startNs);
+}
+
+QByteArray FlightRecorder::toTraceJson()
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+    const quint64 end = s_nextIndex.load(std::memory_order_relaxed);
+    const quint64 begin = end > s_capacity ? end - s_capacity : 0;
+
+    QJsonArray events;
+    for (quint64 index = begin; index < end; ++index) {
+        const Entry &entry = s_entries[index % s_capacity];
+        const quint64 sequence = entry.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * index + 2) {
+            // Still being written, or already overwritten.
+            continue;
+        }
+        const char *category = entry.category.load(std::memory_order_relaxed);
+        const char *name = entry.name.load(std::memory_order_relaxed);
+        const qint64 startNs = entry.startNs.load(std::memory_order_relaxed);
+        const qint64 durationNs = entry.durationNs.load(std::memory_order_relaxed);
+        const quint32 threadId = entry.threadId.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        QJsonObject event;
+        event.insert(QStringLiteral("cat"), QLatin1String(category));
+        event.insert(QStringLiteral("name"), QLatin1String(name));
+        event.insert(QStringLiteral("pid"), pid);
+        event.insert(QStringLiteral("tid"), qint64(threadId));
+        event.insert(QStringLiteral("ts"), startNs / 1000.0);
+        if (durationNs < 0) {
+            event.insert(QStringLiteral("ph"), QStringLiteral("i"));
+            event.insert(QStringLiteral("s"), QStringLiteral("t"));
+        } else {
+            event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+            event.insert(QStringLiteral("dur"), durationNs / 1000.0);
+        }
+        events.append(event);
+    }
+
+    QJsonObject processName;
+    processName.insert(QStringLiteral("name"), QStringLiteral("process_name"));
+    processName.insert(QStringLiteral("ph"), QStringLiteral("M"));
+    processName.insert(QStringLiteral("pid"), pid);
+    processName.insert(QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), QCoreApplication::applicationName()}});
+    events.prepend(processName);
+
+    QJsonObject trace;
+    trace.insert(QStringLiteral("traceEvents"), events);
+    trace.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+    return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+FlightRecorderExport::FlightRecorderExport(QObject *parent)
+    : QObject(parent)
+{
+    m_registered = QDBusConnection::sessionBus().registerObject(s_dbusPath, this, QDBusConnection::ExportScriptableSlots);
+    if (!m_registered) {
+        qWarning() << "Failed to export the flight recorder at" << s_dbusPath;
+    }
+}
+
+FlightRecorderExport::~FlightRecorderExport()
+{
+    // The path may belong to another export, which then stays.
+    if (m_registered) {
+        QDBusConnection::sessionBus().unregisterObject(s_dbusPath);
+    }
+}
+
+QString FlightRecorderExport::trace() const
+{
+    return QString::fromUtf8(FlightRecorder::toTraceJson());
+}
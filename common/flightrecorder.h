@@ -0,0 +1,75 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+/**
+ * Always-on in-process recorder of what kscreen did recently, for reports like "the screen
+ * flickered three times when I docked" where debug output was off.
+ *
+ * Spans and instant events go into a fixed size ring buffer without locking or allocating, the
+ * oldest entries being overwritten. Names and categories are stored as pointers and must be
+ * string literals. The buffer is exported on demand in the Chrome trace event format, which
+ * chrome://tracing and Perfetto load.
+ */
+class FlightRecorder
+{
+public:
+    /**
+     * Records the time from its construction to its destruction.
+     */
+    class Span
+    {
+    public:
+        Span(const char *category, const char *name);
+        ~Span();
+        Q_DISABLE_COPY(Span)
+
+    private:
+        const char *m_category;
+        const char *m_name;
+        qint64 m_startNs;
+    };
+
+    /**
+     * Monotonic nanoseconds, the time base of all entries.
+     */
+    static qint64 now();
+
+    static void instant(const char *category, const char *name);
+    /**
+     * Records a span which started at @p startNs, as returned by now(), and ends now.
+     */
+    static void complete(const char *category, const char *name, qint64 startNs);
+
+    static QByteArray toTraceJson();
+};
+
+/**
+ * Makes the recording of this process available at /org/kde/KScreen/FlightRecorder on the
+ * session bus, for processes which have no D-Bus interface of their own.
+ */
+class FlightRecorderExport : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KScreen.FlightRecorder")
+public:
+    explicit FlightRecorderExport(QObject *parent = nullptr);
+    ~FlightRecorderExport() override;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QString trace() const;
+
+private:
+    bool m_registered = false;
+};
+
+#define KSCREEN_TRACE_CONCAT_(a, b) a##b
+#define KSCREEN_TRACE_CONCAT(a, b) KSCREEN_TRACE_CONCAT_(a, b)
+#define KSCREEN_TRACE_SPAN(category, name) const FlightRecorder::Span KSCREEN_TRACE_CONCAT(kscreenTraceSpan, __LINE__)(category, name)
@@ -6,19 +6,129 @@
 */
 #include "globals.h"
 
+#include <KDirWatch>
+
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
 #include <QStandardPaths>
 #include <QStringBuilder>
+#include <QStringList>
+
+#include <memory>
 
 namespace Globals
 {
 
+namespace
+{
+struct Paths {
+    QString dirPath;
+    // kscreen/ in the system data dirs, in order of precedence
+    QStringList presetDirs;
+    // File path relative to kscreen/ mapped to the absolute path of the preset that wins
+    QHash<QString, QString> presets;
+    bool presetsValid = false;
+    quint64 presetsSerial = 0;
+    std::unique_ptr<KDirWatch> watcher;
+};
+}
+Q_GLOBAL_STATIC(Paths, s_paths)
+
+static void presetsChanged(const QString &path)
+{
+    for (const QString &presetDir : qAsConst(s_paths->presetDirs)) {
+        if (path.startsWith(presetDir) || path == presetDir.chopped(1)) {
+            s_paths->presetsValid = false;
+            s_paths->presetsSerial++;
+            return;
+        }
+    }
+}
+
+static void indexPresets(Paths *paths)
+{
+    paths->presets.clear();
+    paths->presetDirs.clear();
+    // Only watch the data dirs of the current environment.
+    paths->watcher.reset(new KDirWatch);
+    QObject::connect(paths->watcher.get(), &KDirWatch::dirty, &presetsChanged);
+    QObject::connect(paths->watcher.get(), &KDirWatch::created, &presetsChanged);
+    QObject::connect(paths->watcher.get(), &KDirWatch::deleted, &presetsChanged);
+
+    const QString writableLocation = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
+    const QStringList locations = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    for (const QString &location : locations) {
+        if (location == writableLocation) {
+            continue;
+        }
+        const QString presetDir = location % QStringLiteral("/kscreen/");
+        paths->presetDirs.append(presetDir);
+
+        QDirIterator it(presetDir, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const QString filePath = it.next();
+            // Earlier data dirs take precedence, just like with QStandardPaths::locate.
+            const QString relativePath = filePath.mid(presetDir.size());
+            if (!paths->presets.contains(relativePath)) {
+                paths->presets.insert(relativePath, filePath);
+            }
+        }
+
+        paths->watcher->addDir(presetDir, KDirWatch::WatchFiles | KDirWatch::WatchSubDirs);
+    }
+
+    paths->presetsValid = true;
+}
+
+static Paths *indexedPaths()
+{
+    Paths *paths = s_paths;
+    if (!paths->presetsValid) {
+        indexPresets(paths);
+    }
+    return paths;
+}
+
 QString dirPath()
 {
-    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) % QStringLiteral("/kscreen/");
+    Paths *paths = s_paths;
+    if (paths->dirPath.isEmpty()) {
+        paths->dirPath = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) % QStringLiteral("/kscreen/");
+    }
+    return paths->dirPath;
 }
 
 QString findFile(const QString &filePath)
 {
-    return QStandardPaths::locate(QStandardPaths::GenericDataLocation, QStringLiteral("kscreen/") % filePath);
+    const QString localPath = dirPath() % filePath;
+    if (QFileInfo(localPath).isFile()) {
+        return localPath;
+    }
+    return indexedPaths()->presets.value(filePath);
+}
+
+QStringList presetFiles(const QString &dirPath)
+{
+    const Paths *paths = indexedPaths();
+    QStringList filePaths;
+    for (auto it = paths->presets.constBegin(); it != paths->presets.constEnd(); ++it) {
+        if (it.key().startsWith(dirPath)) {
+            filePaths << it.value();
+        }
+    }
+    return filePaths;
+}
+
+quint64 presetsSerial()
+{
+    return s_paths->presetsSerial;
+}
+
+void resetPaths()
+{
+    s_paths->dirPath.clear();
+    s_paths->presetsValid = false;
+    s_paths->presetsSerial++;
 }
 }
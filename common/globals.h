@@ -8,6 +8,7 @@
 #define COMMON_GLOBALS_H
 
 #include <QString>
+#include <QStringList>
 
 namespace Globals
 {
@@ -15,9 +16,28 @@ QString dirPath();
 /**
  * Tries to find the specified file realtive to dirPath(). Also considers presets if there is no
  * existing file under dirPath() yet.
+ *
+ * Presets shipped in the system data dirs are looked up in an index that is built on first use
+ * and rebuilt once a watcher reports changes to them.
  * @returns The abosolute path to a matching file if on exists or an empty string
  */
 QString findFile(const QString &filePath);
+/**
+ * The absolute paths of the presets in the system data dirs below @p dirPath, which is relative
+ * to dirPath() and ends with a slash. Of presets with the same relative path only the one that
+ * findFile() would return is listed.
+ */
+QStringList presetFiles(const QString &dirPath);
+/**
+ * Changes whenever the watcher reports changes to the presets, for caches of what was read
+ * from them.
+ */
+quint64 presetsSerial();
+/**
+ * Resolves the paths again on next use. They are resolved once, so tests that switch to other
+ * data dirs after the first use need to call this.
+ */
+void resetPaths();
 }
 
 #endif
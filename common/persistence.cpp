@@ -0,0 +1,258 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "persistence.h"
+#include "flightrecorder.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+
+class PersistenceWorker : public QThread
+{
+public:
+    explicit PersistenceWorker(Persistence *persistence)
+        : QThread(persistence)
+        , m_persistence(persistence)
+    {
+        setObjectName(QStringLiteral("KScreenPersistence"));
+    }
+
+    void enqueue(const QString &filePath, const QByteArray &data, bool remove, quint64 sequence)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_jobs.contains(filePath)) {
+            m_order.append(filePath);
+        }
+        // Replaces a still queued write to the same file, only the latest data matters.
+        m_jobs.insert(filePath, Job{data, remove, sequence});
+        m_condition.wakeOne();
+    }
+
+    void flush()
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_order.isEmpty() || m_busy) {
+            m_idle.wait(&m_mutex);
+        }
+    }
+
+    void stop()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_quit = true;
+            m_condition.wakeOne();
+        }
+        wait();
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker locker(&m_mutex);
+        while (true) {
+            while (m_order.isEmpty() && !m_quit) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_order.isEmpty()) {
+                // Only leave once everything queued has been written.
+                break;
+            }
+            const QString filePath = m_order.takeFirst();
+            const Job job = m_jobs.take(filePath);
+            m_busy = true;
+            locker.unlock();
+
+            const bool success = m_persistence->perform(filePath, job.data, job.remove);
+            QMetaObject::invokeMethod(
+                m_persistence,
+                [persistence = m_persistence, filePath, sequence = job.sequence, success]() {
+                    persistence->jobDone(filePath, sequence, success);
+                },
+                Qt::QueuedConnection);
+
+            locker.relock();
+            m_busy = false;
+            m_idle.wakeAll();
+        }
+        m_idle.wakeAll();
+    }
+
+private:
+    struct Job {
+        QByteArray data;
+        bool remove = false;
+        quint64 sequence = 0;
+    };
+
+    Persistence *m_persistence;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QWaitCondition m_idle;
+    QStringList m_order;
+    QHash<QString, Job> m_jobs;
+    bool m_busy = false;
+    bool m_quit = false;
+};
+
+FileStamp FileStamp::of(const QFileInfo &fileInfo)
+{
+    return FileStamp{fileInfo.lastModified(), fileInfo.size()};
+}
+
+Persistence::Persistence()
+    : QObject()
+{
+}
+
+Persistence::~Persistence()
+{
+    if (m_worker) {
+        m_worker->stop();
+    }
+}
+
+void Persistence::startWorker()
+{
+    if (m_worker) {
+        return;
+    }
+    m_worker = new PersistenceWorker(this);
+    m_worker->start(QThread::LowPriority);
+}
+
+bool Persistence::isAsynchronous() const
+{
+    return m_worker != nullptr;
+}
+
+bool Persistence::write(const QString &filePath, const QByteArray &data)
+{
+    return schedule(filePath, data, false);
+}
+
+bool Persistence::remove(const QString &filePath)
+{
+    return schedule(filePath, QByteArray(), true);
+}
+
+bool Persistence::schedule(const QString &filePath, const QByteArray &data, bool remove)
+{
+    if (m_worker) {
+        m_pending.insert(filePath, ++m_lastSequence);
+        m_worker->enqueue(filePath, data, remove, m_lastSequence);
+        return true;
+    }
+    const bool success = perform(filePath, data, remove);
+    Q_EMIT written(filePath, success);
+    return success;
+}
+
+void Persistence::jobDone(const QString &filePath, quint64 sequence, bool success)
+{
+    // A job queued later for the same file may still be running.
+    const auto it = m_pending.constFind(filePath);
+    if (it != m_pending.constEnd() && *it == sequence) {
+        m_pending.erase(it);
+    }
+    Q_EMIT written(filePath, success);
+}
+
+void Persistence::flush()
+{
+    if (m_worker) {
+        m_worker->flush();
+    }
+}
+
+bool Persistence::isPending(const QString &filePath) const
+{
+    return m_pending.contains(filePath);
+}
+
+quint64 Persistence::writesPerformed() const
+{
+    return m_writesPerformed.loadRelaxed();
+}
+
+quint64 Persistence::writesSkipped() const
+{
+    return m_writesSkipped.loadRelaxed();
+}
+
+quint64 Persistence::bytesWritten() const
+{
+    return m_bytesWritten.loadRelaxed();
+}
+
+bool Persistence::isOnDisk(const QString &filePath, const QByteArray &data, const QByteArray &hash)
+{
+    const QFileInfo fileInfo(filePath);
+    if (!fileInfo.exists() || fileInfo.size() != data.size()) {
+        return false;
+    }
+    const auto it = m_knownContent.constFind(filePath);
+    if (it != m_knownContent.constEnd() && it->stamp == FileStamp::of(fileInfo)) {
+        // File is as we last saw it, no need to read it back.
+        return it->hash == hash;
+    }
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray diskHash = QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5);
+    m_knownContent.insert(filePath, KnownContent{diskHash, FileStamp::of(fileInfo)});
+    return diskHash == hash;
+}
+
+bool Persistence::perform(const QString &filePath, const QByteArray &data, bool remove)
+{
+    KSCREEN_TRACE_SPAN("io", remove ? "remove" : "write");
+    if (remove) {
+        m_knownContent.remove(filePath);
+        if (!QFile::exists(filePath)) {
+            m_writesSkipped++;
+            return true;
+        }
+        m_writesPerformed++;
+        return QFile::remove(filePath);
+    }
+
+    const QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+    if (isOnDisk(filePath, data, hash)) {
+        m_writesSkipped++;
+        return true;
+    }
+
+    if (!QDir().mkpath(QFileInfo(filePath).path())) {
+        qWarning() << "Failed to create directory for" << filePath;
+        return false;
+    }
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open" << filePath << "for writing:" << file.errorString();
+        return false;
+    }
+    file.write(data);
+    if (!file.commit()) {
+        qWarning() << "Failed to write" << filePath << ":" << file.errorString();
+        m_knownContent.remove(filePath);
+        return false;
+    }
+    m_writesPerformed++;
+    m_bytesWritten += data.size();
+
+    m_knownContent.insert(filePath, KnownContent{hash, FileStamp::of(QFileInfo(filePath))});
+    return true;
+}
@@ -0,0 +1,107 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "singleton.h"
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+class PersistenceWorker;
+class QFileInfo;
+
+/**
+ * What a file looked like when it was last seen, to tell without reading it whether it was
+ * changed since.
+ */
+struct FileStamp {
+    QDateTime lastModified;
+    qint64 size = -1;
+
+    static FileStamp of(const QFileInfo &fileInfo);
+
+    bool operator==(const FileStamp &other) const
+    {
+        return size == other.size && lastModified == other.lastModified;
+    }
+    bool operator!=(const FileStamp &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+/**
+ * Writes kscreen's files atomically through QSaveFile.
+ *
+ * By default writes happen synchronously. Once startWorker() was called they are handed
+ * to a write-behind thread instead: callers pass an immutable snapshot of the serialized data,
+ * repeated writes to the same path that are still queued are coalesced, and flush() blocks until
+ * everything queued so far is on disk.
+ *
+ * Writes whose content is identical to what is already on disk are skipped. For that a hash of
+ * the last content written or found per file is kept together with the file's modification time,
+ * so that unchanged files need not be read back.
+ */
+class Persistence : public QObject, public Singleton<Persistence>
+{
+    Q_OBJECT
+public:
+    void startWorker();
+    bool isAsynchronous() const;
+
+    /**
+     * @returns whether the data was written or, with the worker running, queued for writing
+     */
+    bool write(const QString &filePath, const QByteArray &data);
+    bool remove(const QString &filePath);
+    void flush();
+    /**
+     * Whether a write or removal of @p filePath was queued and is not done yet. Change
+     * notifications for such a file are about an older state than what was handed to us.
+     */
+    bool isPending(const QString &filePath) const;
+
+    quint64 writesPerformed() const;
+    quint64 writesSkipped() const;
+    quint64 bytesWritten() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted in the thread of this object once @p filePath was written or removed.
+     */
+    void written(const QString &filePath, bool success);
+
+private:
+    friend class Singleton<Persistence>;
+    explicit Persistence();
+    // Flushes all pending writes and stops the worker thread.
+    ~Persistence() override;
+
+    friend class PersistenceWorker;
+    bool schedule(const QString &filePath, const QByteArray &data, bool remove);
+    void jobDone(const QString &filePath, quint64 sequence, bool success);
+    // Only ever called from one thread, the worker's or, without worker, ours.
+    bool perform(const QString &filePath, const QByteArray &data, bool remove);
+    bool isOnDisk(const QString &filePath, const QByteArray &data, const QByteArray &hash);
+
+    struct KnownContent {
+        QByteArray hash;
+        FileStamp stamp;
+    };
+    QHash<QString, KnownContent> m_knownContent;
+
+    PersistenceWorker *m_worker = nullptr;
+    // The sequence number of the latest job queued per file
+    QHash<QString, quint64> m_pending;
+    quint64 m_lastSequence = 0;
+    QAtomicInteger<quint64> m_writesPerformed;
+    QAtomicInteger<quint64> m_writesSkipped;
+    QAtomicInteger<quint64> m_bytesWritten;
+};
@@ -0,0 +1,37 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+/**
+ * The process wide instance of @p T, created on first use of self() and deleted by destroy().
+ *
+ * @p T keeps its constructor and destructor private and befriends Singleton<T>.
+ */
+template<typename T>
+class Singleton
+{
+public:
+    static T *self()
+    {
+        if (!s_instance) {
+            s_instance = new T();
+        }
+        return s_instance;
+    }
+
+    static void destroy()
+    {
+        delete s_instance;
+        s_instance = nullptr;
+    }
+
+protected:
+    Singleton() = default;
+    ~Singleton() = default;
+
+private:
+    static inline T *s_instance = nullptr;
+};
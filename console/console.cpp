@@ -5,11 +5,17 @@
 */
 
 #include "console.h"
+#include "../common/fileformat.h"
 
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusReply>
 #include <QDebug>
 #include <QDir>
+#include <QDirIterator>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QTextStream>
 
@@ -140,24 +146,95 @@ void Console::printSerializations()
     QStringList files = dir.entryList(QDir::Files);
     qDebug() << "Number of files: " << files.count() << Qt::endl;
 
-    QJsonDocument parser;
     Q_FOREACH (const QString fileName, files) {
-        QJsonParseError error;
         qDebug() << fileName;
         QFile file(path + QLatin1Char('/') + fileName);
         file.open(QFile::ReadOnly);
-        parser.fromJson(file.readAll(), &error);
-        if (error.error != QJsonParseError::NoError) {
+        const QJsonDocument document = FileFormat::decode(file.readAll());
+        if (document.isNull()) {
             qDebug() << "    "
                      << "can't parse file";
-            qDebug() << "    " << error.errorString();
             continue;
         }
 
-        qDebug() << parser.toJson(QJsonDocument::Indented) << Qt::endl;
+        qDebug() << document.toJson(QJsonDocument::Indented) << Qt::endl;
     }
 }
 
+int Console::convertFiles(const QString &formatName)
+{
+    FileFormat::Format format;
+    if (formatName == QLatin1String("json")) {
+        format = FileFormat::Format::Json;
+    } else if (formatName == QLatin1String("cbor")) {
+        format = FileFormat::Format::Cbor;
+    } else {
+        qDebug() << "Unknown format" << formatName << "- expected json or cbor";
+        return 1;
+    }
+
+    const QString path = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QLatin1String("/kscreen/");
+    int converted = 0;
+    int failed = 0;
+    QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString filePath = it.next();
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        const QByteArray data = file.readAll();
+        file.close();
+        if (FileFormat::detect(data) == format) {
+            continue;
+        }
+        const QJsonDocument document = FileFormat::decode(data);
+        if (document.isNull()) {
+            // Not one of our JSON or CBOR files, e.g. the indexed config store.
+            continue;
+        }
+        QSaveFile saveFile(filePath);
+        if (!saveFile.open(QIODevice::WriteOnly)) {
+            qDebug() << "Failed to open" << filePath << saveFile.errorString();
+            failed++;
+            continue;
+        }
+        saveFile.write(FileFormat::encode(document, format));
+        if (!saveFile.commit()) {
+            qDebug() << "Failed to write" << filePath << saveFile.errorString();
+            failed++;
+            continue;
+        }
+        qDebug() << "Converted" << filePath;
+        converted++;
+    }
+    qDebug() << "Converted" << converted << "files," << failed << "failed";
+    return failed == 0 ? 0 : 1;
+}
+
+int Console::printTrace(const QString &service)
+{
+    QDBusMessage call;
+    if (service.isEmpty()) {
+        call = QDBusMessage::createMethodCall(QStringLiteral("org.kde.kded5"),
+                                              QStringLiteral("/modules/kscreen"),
+                                              QStringLiteral("org.kde.KScreen"),
+                                              QStringLiteral("flightRecording"));
+    } else {
+        call = QDBusMessage::createMethodCall(service,
+                                              QStringLiteral("/org/kde/KScreen/FlightRecorder"),
+                                              QStringLiteral("org.kde.KScreen.FlightRecorder"),
+                                              QStringLiteral("trace"));
+    }
+    const QDBusReply<QString> reply = QDBusConnection::sessionBus().call(call);
+    if (!reply.isValid()) {
+        qDebug() << "Failed to get the trace:" << reply.error().message();
+        return 1;
+    }
+    QTextStream(stdout) << reply.value() << Qt::endl;
+    return 0;
+}
+
 void Console::monitor()
 {
     ConfigMonitor::instance()->addConfig(m_config);
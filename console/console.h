@@ -22,6 +22,18 @@ public:
     explicit Console(const KScreen::ConfigPtr &config);
     ~Console() override;
 
+    /**
+     * Rewrites all files kscreen persisted in the format named @p formatName (json or cbor).
+     * @returns the exit code for the command
+     */
+    static int convertFiles(const QString &formatName);
+    /**
+     * Prints the flight recording of the KScreen daemon, or of the process owning @p service,
+     * as Chrome trace JSON.
+     * @returns the exit code for the command
+     */
+    static int printTrace(const QString &service);
+
 public Q_SLOTS:
     void printConfig();
     void printJSONConfig();
@@ -86,9 +86,12 @@ int main(int argc, char *argv[])
              "  config          Show KScreen config files\n"
              "  outputs         Show output information\n"
              "  monitor         Monitor for changes\n"
-             "  json            Show current KScreen config"));
+             "  json            Show current KScreen config\n"
+             "  convert FORMAT  Convert stored KScreen files to json or cbor\n"
+             "  trace [SERVICE] Print the recent activity of the KScreen daemon, or of the\n"
+             "                  KScreen settings running as SERVICE, as Chrome trace JSON"));
     parser.addHelpOption();
-    parser.addPositionalArgument(QStringLiteral("command"), i18n("Command to execute"), QStringLiteral("bug|config|outputs|monitor|json"));
+    parser.addPositionalArgument(QStringLiteral("command"), i18n("Command to execute"), QStringLiteral("bug|config|outputs|monitor|json|convert|trace"));
     parser.addPositionalArgument(QStringLiteral("[args...]"), i18n("Arguments for the specified command"));
 
     parser.process(app);
@@ -98,6 +101,14 @@ int main(int argc, char *argv[])
         command = parser.positionalArguments().constFirst();
     }
 
+    if (command == QLatin1String("convert")) {
+        // Works on the stored files only, no need to ask the backend for the current config.
+        return Console::convertFiles(parser.positionalArguments().value(1));
+    }
+    if (command == QLatin1String("trace")) {
+        return Console::printTrace(parser.positionalArguments().value(1));
+    }
+
     qDebug() << "START: Requesting Config";
 
     KScreen::GetConfigOperation *op = new KScreen::GetConfigOperation();
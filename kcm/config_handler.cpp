@@ -4,6 +4,7 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "config_handler.h"
+#include "../common/flightrecorder.h"
 
 #include "kcm_screen_debug.h"
 #include "output_model.h"
@@ -11,12 +12,36 @@
 #include <kscreen/configmonitor.h>
 #include <kscreen/getconfigoperation.h>
 #include <kscreen/output.h>
+#include <kscreen/setconfigoperation.h>
 
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QGuiApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QRect>
 
+namespace KScreen
+{
+namespace ConfigSerializer
+{
+// Exported private symbol in configserializer_p.h in KScreen
+extern QJsonObject serializeConfig(const KScreen::ConfigPtr &config);
+}
+}
+
 using namespace KScreen;
 
+static QDBusMessage daemonMethodCall(const QString &method)
+{
+    return QDBusMessage::createMethodCall(QStringLiteral("org.kde.kded5"),
+                                          QStringLiteral("/modules/kscreen"),
+                                          QStringLiteral("org.kde.KScreen"),
+                                          method);
+}
+
 ConfigHandler::ConfigHandler(QObject *parent)
     : QObject(parent)
 {
@@ -26,10 +51,12 @@ void ConfigHandler::setConfig(KScreen::ConfigPtr config)
 {
     m_config = config;
     m_initialConfig = m_config->clone();
-    m_initialControl.reset(new ControlConfig(m_initialConfig));
 
     KScreen::ConfigMonitor::instance()->addConfig(m_config);
     m_control.reset(new ControlConfig(config));
+    // Same outputs and same control files, no need to read them again.
+    m_initialControl.reset(new ControlConfig(m_initialConfig, *m_control));
+    fetchDaemonGeneration();
 
     m_outputModel = new OutputModel(this);
     connect(m_outputModel, &OutputModel::positionChanged, this, &ConfigHandler::checkScreenNormalization);
@@ -102,9 +129,85 @@ void ConfigHandler::updateInitialData()
         for (const auto &output : outputs) {
             resetScale(output);
         }
-        m_initialControl.reset(new ControlConfig(m_initialConfig));
+        if (m_initialConfig->connectedOutputsHash() == m_config->connectedOutputsHash()) {
+            // The control files were just written from m_control.
+            m_initialControl.reset(new ControlConfig(m_initialConfig, *m_control));
+        } else {
+            m_initialControl.reset(new ControlConfig(m_initialConfig));
+        }
         checkNeedsSave();
     });
+    fetchDaemonGeneration();
+}
+
+void ConfigHandler::fetchDaemonGeneration()
+{
+    m_daemonGeneration = 0;
+    auto *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(daemonMethodCall(QStringLiteral("configurationGeneration"))), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        const QDBusPendingReply<quint32> reply = *watcher;
+        if (reply.isError()) {
+            qCDebug(KSCREEN_KCM) << "KScreen daemon not available:" << reply.error().message();
+            return;
+        }
+        m_daemonGeneration = reply.value();
+    });
+}
+
+void ConfigHandler::applyConfig()
+{
+    if (m_applyWatcher) {
+        // Sent with the generation the daemon replies with, applying it here would race the daemon.
+        m_applyQueued = true;
+        return;
+    }
+    if (!m_control || m_daemonGeneration == 0) {
+        applyDirectly();
+        Q_EMIT configApplied();
+        return;
+    }
+    const QByteArray layout = QJsonDocument(ConfigSerializer::serializeConfig(m_config)).toJson(QJsonDocument::Compact);
+    const QByteArray control = QJsonDocument::fromVariant(m_control->toVariantMap()).toJson(QJsonDocument::Compact);
+
+    QDBusMessage call = daemonMethodCall(QStringLiteral("applyConfiguration"));
+    call << QString::fromUtf8(layout) << QString::fromUtf8(control) << m_daemonGeneration;
+    // The daemon replies once it applied the config.
+    m_applyWatcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(call), this);
+    connect(m_applyWatcher, &QDBusPendingCallWatcher::finished, this, [this, startNs = FlightRecorder::now()]() {
+        FlightRecorder::complete("dbus", "applyConfiguration", startNs);
+        takeDaemonReply();
+        if (m_applyQueued) {
+            m_applyQueued = false;
+            applyConfig();
+            return;
+        }
+        Q_EMIT configApplied();
+    });
+}
+
+void ConfigHandler::takeDaemonReply()
+{
+    const QDBusPendingReply<quint32> reply = *m_applyWatcher;
+    m_applyWatcher->deleteLater();
+    m_applyWatcher = nullptr;
+    if (reply.isError() || reply.value() == 0) {
+        qCDebug(KSCREEN_KCM) << "KScreen daemon did not take the config, applying it directly";
+        m_daemonGeneration = 0;
+        applyDirectly();
+        return;
+    }
+    m_daemonGeneration = reply.value();
+}
+
+void ConfigHandler::applyDirectly()
+{
+    writeControl();
+
+    // Block until operation is completed, otherwise ConfigModule might terminate before we get
+    // to execute the Operation.
+    auto *op = new SetConfigOperation(m_config);
+    op->exec();
 }
 
 bool ConfigHandler::shouldTestNewSettings()
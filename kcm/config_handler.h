@@ -12,6 +12,7 @@
 #include <memory>
 
 class OutputModel;
+class QDBusPendingCallWatcher;
 
 class ConfigHandler : public QObject
 {
@@ -69,6 +70,18 @@ public:
     void setRgbRange(const KScreen::OutputPtr &output, KScreen::Output::RgbRange value);
 
     void writeControl();
+    /**
+     * Applies and saves the config and control data, preferably through the KScreen daemon so
+     * that it stays the only writer of the config files. They are applied and written here if the
+     * daemon is not running or rejected the config because it changed in the meantime. While the
+     * daemon is still busy with a previous config, the new one is sent once it replied.
+     * configApplied() is emitted once the config is applied.
+     */
+    void applyConfig();
+    bool isApplyingConfig() const
+    {
+        return m_applyWatcher != nullptr;
+    }
 
     void checkNeedsSave();
     bool shouldTestNewSettings();
@@ -80,6 +93,7 @@ Q_SIGNALS:
     void needsSaveChecked(bool need);
     void retentionChanged();
     void outputConnect(bool connected);
+    void configApplied();
 
 private:
     void checkScreenNormalization();
@@ -96,6 +110,9 @@ private:
      * @return true, if you should check for a save or test the new configuration
      */
     bool checkSaveandTestCommon(bool isSaveCheck);
+    void fetchDaemonGeneration();
+    void applyDirectly();
+    void takeDaemonReply();
 
     KScreen::ConfigPtr m_config = nullptr;
     KScreen::ConfigPtr m_initialConfig;
@@ -106,4 +123,8 @@ private:
     std::unique_ptr<ControlConfig> m_initialControl;
     Control::OutputRetention m_initialRetention = Control::OutputRetention::Undefined;
     QSize m_lastNormalizedScreenSize;
+    // Generation of the daemon's config that m_config is based on, 0 if unknown.
+    quint32 m_daemonGeneration = 0;
+    QDBusPendingCallWatcher *m_applyWatcher = nullptr;
+    bool m_applyQueued = false;
 };
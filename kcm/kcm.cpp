@@ -6,6 +6,7 @@
 #include "kcm.h"
 
 #include "../common/control.h"
+#include "../common/flightrecorder.h"
 #include "../common/orientation_sensor.h"
 #include "config_handler.h"
 #include "globalscalesettings.h"
@@ -18,7 +19,6 @@
 #include <kscreen/getconfigoperation.h>
 #include <kscreen/log.h>
 #include <kscreen/output.h>
-#include <kscreen/setconfigoperation.h>
 
 #include <KConfigGroup>
 #include <KLocalizedString>
@@ -38,6 +38,7 @@ KCMKScreen::KCMKScreen(QObject *parent, const KPluginMetaData &data, const QVari
     qmlRegisterType<KScreen::Output>("org.kde.private.kcm.kscreen", 1, 0, "Output");
     qmlRegisterUncreatableType<Control>("org.kde.private.kcm.kscreen", 1, 0, "Control", QStringLiteral("Provides only the OutputRetention enum class"));
     Log::instance();
+    new FlightRecorderExport(this);
 
     setButtons(Apply);
 
@@ -57,6 +58,7 @@ KCMKScreen::KCMKScreen(QObject *parent, const KPluginMetaData &data, const QVari
 
 void KCMKScreen::configReady(ConfigOperation *op)
 {
+    FlightRecorder::instant("kcm", "configReady");
     qCDebug(KSCREEN_KCM) << "Reading in config now.";
     if (op->hasError()) {
         m_configHandler.reset();
@@ -120,6 +122,7 @@ void KCMKScreen::updateFromBackend()
 
 void KCMKScreen::doSave(bool force)
 {
+    KSCREEN_TRACE_SPAN("kcm", "save");
     if (!m_configHandler) {
         Q_EMIT errorOnSave();
         return;
@@ -164,14 +167,19 @@ void KCMKScreen::doSave(bool force)
         exportGlobalScale();
     }
 
-    m_configHandler->writeControl();
-
-    // Store the current config, apply settings. Block until operation is
-    // completed, otherwise ConfigModule might terminate before we get to
-    // execute the Operation.
-    auto *op = new SetConfigOperation(config);
     m_stopUpdatesFromBackend = true;
-    op->exec();
+    // Store the current config, apply settings. Continued in configApplied().
+    m_configHandler->applyConfig();
+}
+
+void KCMKScreen::configApplied(ConfigHandler *handler)
+{
+    if (handler != m_configHandler.get()) {
+        // Reloaded in the meantime.
+        m_settingsReverted = false;
+        m_stopUpdatesFromBackend = false;
+        return;
+    }
 
     const auto updateInitialData = [this]() {
         if (!m_configHandler) {
@@ -304,6 +312,7 @@ void KCMKScreen::defaults()
 
 void KCMKScreen::load()
 {
+    KSCREEN_TRACE_SPAN("kcm", "load");
     qCDebug(KSCREEN_KCM) << "About to read in config.";
 
     ManagedConfigModule::load();
@@ -321,10 +330,19 @@ void KCMKScreen::load()
     auto *oldConfig = m_configHandler.release();
     if (oldConfig) {
         emit outputModelChanged();
-        delete oldConfig;
+        if (oldConfig->isApplyingConfig()) {
+            // It applies the config itself if the daemon does not take it after all.
+            connect(oldConfig, &ConfigHandler::configApplied, oldConfig, &QObject::deleteLater);
+        } else {
+            delete oldConfig;
+        }
     }
 
     m_configHandler.reset(new ConfigHandler(this));
+    ConfigHandler *handler = m_configHandler.get();
+    connect(handler, &ConfigHandler::configApplied, this, [this, handler]() {
+        configApplied(handler);
+    });
     Q_EMIT perOutputScalingChanged();
     connect(m_configHandler.get(), &ConfigHandler::outputModelChanged, this, &KCMKScreen::outputModelChanged);
     connect(m_configHandler.get(), &ConfigHandler::outputConnect, this, [this](bool connected) {
@@ -101,6 +101,7 @@ private:
     void exportGlobalScale();
 
     void configReady(KScreen::ConfigOperation *op);
+    void configApplied(ConfigHandler *handler);
     void continueNeedsSaveCheck(bool needs);
 
     std::unique_ptr<OutputIdentifier> m_outputIdentifier;
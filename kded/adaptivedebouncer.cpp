@@ -0,0 +1,79 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "adaptivedebouncer.h"
+#include "../common/flightrecorder.h"
+#include "kscreen_daemon_debug.h"
+
+#include <algorithm>
+
+AdaptiveDebouncer::AdaptiveDebouncer(std::chrono::milliseconds minWindow, std::chrono::milliseconds maxWindow, QObject *parent)
+    : QObject(parent)
+    , m_minWindowMs(minWindow.count())
+    , m_maxWindowMs(std::max(minWindow, maxWindow).count())
+{
+    m_clock.start();
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &AdaptiveDebouncer::trigger);
+}
+
+std::chrono::milliseconds AdaptiveDebouncer::window(const QString &source) const
+{
+    // Some slack on top of the longest gap seen, the exact timing varies between plugs.
+    const qint64 burstMs = m_sources.value(source).burstMs;
+    return std::chrono::milliseconds(std::clamp(burstMs + burstMs / 2, m_minWindowMs, m_maxWindowMs));
+}
+
+bool AdaptiveDebouncer::isActive() const
+{
+    return m_timer.isActive();
+}
+
+void AdaptiveDebouncer::event(const QString &source)
+{
+    const qint64 now = m_clock.elapsed();
+    Source &state = m_sources[source];
+
+    if (!m_burstSources.contains(source)) {
+        if (state.lastTrigger >= 0 && now - state.lastTrigger < m_maxWindowMs) {
+            // The previous burst was not over yet, learn its full length.
+            const qint64 burstMs = std::min(now - state.burstStart, m_maxWindowMs);
+            if (burstMs > state.burstMs) {
+                qCDebug(KSCREEN_KDED) << "Events of" << source << "continued" << now - state.lastTrigger << "ms after their burst, growing its window to"
+                                      << std::clamp(burstMs + burstMs / 2, m_minWindowMs, m_maxWindowMs) << "ms";
+                state.burstMs = burstMs;
+            }
+        } else {
+            state.burstStart = now;
+        }
+        m_burstSources.insert(source);
+    }
+    state.lastEvent = now;
+
+    // The window of the slowest source in the burst decides.
+    std::chrono::milliseconds interval(0);
+    for (const QString &burstSource : qAsConst(m_burstSources)) {
+        interval = std::max(interval, window(burstSource));
+    }
+    m_timer.start(interval);
+}
+
+void AdaptiveDebouncer::trigger()
+{
+    FlightRecorder::instant("timer", "changeDebouncer");
+    const qint64 now = m_clock.elapsed();
+    for (const QString &source : qAsConst(m_burstSources)) {
+        Source &state = m_sources[source];
+        const qint64 burstMs = state.lastEvent - state.burstStart;
+        if (burstMs < state.burstMs) {
+            // Decay slowly, so that a single quick plug does not undo what was learned.
+            state.burstMs = (3 * state.burstMs + burstMs) / 4;
+        }
+        state.lastTrigger = now;
+    }
+    qCDebug(KSCREEN_KDED) << "Event burst of" << m_burstSources.values() << "is over, triggering";
+    m_burstSources.clear();
+    Q_EMIT triggered();
+}
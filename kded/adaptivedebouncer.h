@@ -0,0 +1,59 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_ADAPTIVEDEBOUNCER_H
+#define KDED_ADAPTIVEDEBOUNCER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+#include <chrono>
+
+/**
+ * Compresses bursts of events into one trailing triggered() signal.
+ *
+ * Events are reported per source, for example a connector name. The quiet period that ends a
+ * burst is learned per source. When a source keeps sending events shortly after a burst had been
+ * considered over, its window grows to cover the whole burst. Bursts that end early shrink it
+ * again slowly. Windows stay within the given bounds. triggered() always follows the last event,
+ * no event is dropped without one.
+ */
+class AdaptiveDebouncer : public QObject
+{
+    Q_OBJECT
+public:
+    AdaptiveDebouncer(std::chrono::milliseconds minWindow, std::chrono::milliseconds maxWindow, QObject *parent = nullptr);
+
+    void event(const QString &source);
+    bool isActive() const;
+
+    std::chrono::milliseconds window(const QString &source) const;
+
+Q_SIGNALS:
+    void triggered();
+
+private:
+    void trigger();
+
+    struct Source {
+        // Learned duration of the bursts of this source
+        qint64 burstMs = 0;
+        qint64 burstStart = -1;
+        qint64 lastEvent = -1;
+        qint64 lastTrigger = -1;
+    };
+
+    const qint64 m_minWindowMs;
+    const qint64 m_maxWindowMs;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+    QHash<QString, Source> m_sources;
+    QSet<QString> m_burstSources;
+};
+
+#endif
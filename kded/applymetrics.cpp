@@ -0,0 +1,132 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "applymetrics.h"
+#include "../common/persistence.h"
+
+#include <algorithm>
+
+// Upper bounds of the histogram buckets in milliseconds, the last bucket takes everything above.
+static const QVector<int> s_bucketBoundsMs = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+
+static QString stageName(ApplyMetrics::Stage stage)
+{
+    switch (stage) {
+    case ApplyMetrics::Stage::Debounce:
+        return QStringLiteral("debounce");
+    case ApplyMetrics::Stage::Resolve:
+        return QStringLiteral("resolve");
+    case ApplyMetrics::Stage::Parse:
+        return QStringLiteral("parse");
+    case ApplyMetrics::Stage::Generate:
+        return QStringLiteral("generate");
+    case ApplyMetrics::Stage::Apply:
+        return QStringLiteral("apply");
+    case ApplyMetrics::Stage::Total:
+        return QStringLiteral("total");
+    }
+    Q_UNREACHABLE();
+}
+
+static QString counterName(ApplyMetrics::Counter counter)
+{
+    switch (counter) {
+    case ApplyMetrics::Counter::Applies:
+        return QStringLiteral("applies");
+    case ApplyMetrics::Counter::SkippedApplies:
+        return QStringLiteral("skippedApplies");
+    case ApplyMetrics::Counter::Saves:
+        return QStringLiteral("saves");
+    }
+    Q_UNREACHABLE();
+}
+
+void ApplyMetrics::begin(Stage stage, bool restart)
+{
+    Latencies &latencies = m_latencies[static_cast<int>(stage)];
+    if (restart || !latencies.timer.isValid()) {
+        latencies.timer.start();
+    }
+}
+
+void ApplyMetrics::end(Stage stage)
+{
+    Latencies &latencies = m_latencies[static_cast<int>(stage)];
+    if (!latencies.timer.isValid()) {
+        return;
+    }
+    const qint64 us = latencies.timer.nsecsElapsed() / 1000;
+    latencies.timer.invalidate();
+    record(stage, us);
+}
+
+void ApplyMetrics::record(Stage stage, qint64 us)
+{
+    Latencies &latencies = m_latencies[static_cast<int>(stage)];
+    if (latencies.samples.size() < s_samples) {
+        latencies.samples.append(us);
+    } else {
+        latencies.samples[latencies.next] = us;
+    }
+    latencies.next = (latencies.next + 1) % s_samples;
+    latencies.count++;
+    latencies.sumUs += us;
+    latencies.maxUs = std::max(latencies.maxUs, us);
+}
+
+void ApplyMetrics::count(Counter counter)
+{
+    m_counters[static_cast<int>(counter)]++;
+}
+
+QVariantMap ApplyMetrics::toVariantMap() const
+{
+    QVariantMap counters;
+    for (int i = 0; i < int(m_counters.size()); ++i) {
+        counters.insert(counterName(static_cast<Counter>(i)), m_counters[i]);
+    }
+    counters.insert(QStringLiteral("writes"), Persistence::self()->writesPerformed());
+    counters.insert(QStringLiteral("skippedWrites"), Persistence::self()->writesSkipped());
+    counters.insert(QStringLiteral("bytesWritten"), Persistence::self()->bytesWritten());
+
+    QVariantMap stages;
+    for (int i = 0; i < s_stageCount; ++i) {
+        const Latencies &latencies = m_latencies[i];
+        QVector<qint64> samples = latencies.samples;
+        std::sort(samples.begin(), samples.end());
+        const auto percentileMs = [&samples](int percentile) {
+            return samples.isEmpty() ? 0.0 : samples.at((samples.size() - 1) * percentile / 100) / 1000.0;
+        };
+
+        QVariantList buckets;
+        auto sample = samples.cbegin();
+        for (int boundMs : s_bucketBoundsMs) {
+            const auto bucketEnd = std::upper_bound(sample, samples.cend(), qint64(boundMs) * 1000);
+            buckets << int(bucketEnd - sample);
+            sample = bucketEnd;
+        }
+        buckets << int(samples.cend() - sample);
+
+        QVariantMap stage;
+        stage.insert(QStringLiteral("count"), latencies.count);
+        stage.insert(QStringLiteral("sumMs"), latencies.sumUs / 1000.0);
+        stage.insert(QStringLiteral("maxMs"), latencies.maxUs / 1000.0);
+        stage.insert(QStringLiteral("p50Ms"), percentileMs(50));
+        stage.insert(QStringLiteral("p95Ms"), percentileMs(95));
+        stage.insert(QStringLiteral("buckets"), buckets);
+        stages.insert(stageName(static_cast<Stage>(i)), stage);
+    }
+
+    QVariantList bucketBounds;
+    for (int boundMs : s_bucketBoundsMs) {
+        bucketBounds << boundMs;
+    }
+
+    QVariantMap map;
+    map.insert(QStringLiteral("counters"), counters);
+    map.insert(QStringLiteral("latencies"), stages);
+    map.insert(QStringLiteral("bucketBoundsMs"), bucketBounds);
+    return map;
+}
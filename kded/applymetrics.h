@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_APPLYMETRICS_H
+#define KDED_APPLYMETRICS_H
+
+#include <QElapsedTimer>
+#include <QVariantMap>
+#include <QVector>
+
+#include <array>
+
+/**
+ * Latencies of the stages between an output being plugged and its config being applied, and
+ * counters of what the daemon did.
+ *
+ * Latency histograms cover the most recent samples of each stage, totals cover the whole lifetime
+ * of the daemon.
+ */
+class ApplyMetrics
+{
+public:
+    enum class Stage {
+        // From the first connection change until the config is resolved
+        Debounce,
+        // Finding or generating the config to apply
+        Resolve,
+        Parse,
+        Generate,
+        // The backend applying the config
+        Apply,
+        // From the first connection change until the config is applied
+        Total,
+    };
+    enum class Counter {
+        Applies,
+        SkippedApplies,
+        Saves,
+    };
+
+    /**
+     * Starts timing @p stage. Unless @p restart is set a stage already being timed keeps its start.
+     */
+    void begin(Stage stage, bool restart = true);
+    /**
+     * Records the time since @p stage began, if it did.
+     */
+    void end(Stage stage);
+    void count(Counter counter);
+
+    QVariantMap toVariantMap() const;
+
+private:
+    friend class TestApplyMetrics;
+
+    void record(Stage stage, qint64 us);
+
+    static constexpr int s_stageCount = static_cast<int>(Stage::Total) + 1;
+    static constexpr int s_samples = 128;
+
+    struct Latencies {
+        QElapsedTimer timer;
+        // Ring buffer of the most recent samples in microseconds
+        QVector<qint64> samples;
+        int next = 0;
+        quint64 count = 0;
+        qint64 sumUs = 0;
+        qint64 maxUs = 0;
+    };
+
+    std::array<Latencies, s_stageCount> m_latencies;
+    std::array<quint64, static_cast<int>(Counter::Saves) + 1> m_counters = {};
+};
+
+#endif
@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "applyscheduler.h"
+#include "../common/flightrecorder.h"
+#include "kscreen_daemon_debug.h"
+
+#include <kscreen/setconfigoperation.h>
+
+#include <utility>
+
+ApplyScheduler::ApplyScheduler(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ApplyScheduler::~ApplyScheduler()
+{
+    qCDebug(KSCREEN_KDED) << "Configs superseded before being applied:" << m_coalesced;
+}
+
+void ApplyScheduler::schedule(const KScreen::ConfigPtr &config)
+{
+    if (m_operation) {
+        if (m_pending) {
+            m_coalesced++;
+        }
+        qCDebug(KSCREEN_KDED) << "Config apply in flight, queuing the latest config";
+        m_pending = config;
+        return;
+    }
+    start(config);
+}
+
+void ApplyScheduler::cancel()
+{
+    if (m_pending) {
+        m_coalesced++;
+    }
+    m_pending.reset();
+}
+
+bool ApplyScheduler::isBusy() const
+{
+    return m_operation != nullptr;
+}
+
+void ApplyScheduler::start(const KScreen::ConfigPtr &config)
+{
+    m_operation = new KScreen::SetConfigOperation(config);
+    m_operationConfig = config;
+    m_operationStartNs = FlightRecorder::now();
+    connect(m_operation, &KScreen::ConfigOperation::finished, this, &ApplyScheduler::operationFinished);
+}
+
+void ApplyScheduler::operationFinished(KScreen::ConfigOperation *operation)
+{
+    Q_ASSERT(operation == m_operation);
+    FlightRecorder::complete("backend", "SetConfigOperation", m_operationStartNs);
+    const bool success = !operation->hasError();
+    if (!success) {
+        qCWarning(KSCREEN_KDED) << "Applying config failed:" << operation->errorString();
+    }
+    m_operation = nullptr;
+    const KScreen::ConfigPtr config = std::move(m_operationConfig);
+    m_operationConfig.reset();
+
+    if (m_pending) {
+        // Something changed in the meantime, apply the latest state.
+        start(std::exchange(m_pending, KScreen::ConfigPtr()));
+        return;
+    }
+    qCDebug(KSCREEN_KDED) << "Config applied";
+    Q_EMIT idle(config, success);
+}
@@ -0,0 +1,63 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_APPLYSCHEDULER_H
+#define KDED_APPLYSCHEDULER_H
+
+#include <kscreen/config.h>
+
+#include <QObject>
+
+namespace KScreen
+{
+class ConfigOperation;
+class SetConfigOperation;
+}
+
+/**
+ * Applies configs to the backend one at a time.
+ *
+ * At most one SetConfigOperation is in flight. A config scheduled in the meantime takes the single
+ * pending slot, replacing whatever was pending before, and is applied once the running operation
+ * finished. Bursts of changes thus cost at most two backend round trips and intermediate states
+ * are never applied.
+ */
+class ApplyScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ApplyScheduler(QObject *parent = nullptr);
+    ~ApplyScheduler() override;
+
+    /**
+     * Applies @p config now, or after the operation in flight if there is one.
+     */
+    void schedule(const KScreen::ConfigPtr &config);
+    /**
+     * Drops the pending config. The operation in flight can not be aborted, idle() is emitted
+     * for it once it finished.
+     */
+    void cancel();
+
+    bool isBusy() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when the last scheduled config was applied and nothing is pending.
+     */
+    void idle(const KScreen::ConfigPtr &config, bool success);
+
+private:
+    void start(const KScreen::ConfigPtr &config);
+    void operationFinished(KScreen::ConfigOperation *operation);
+
+    KScreen::SetConfigOperation *m_operation = nullptr;
+    KScreen::ConfigPtr m_operationConfig;
+    qint64 m_operationStartNs = 0;
+    KScreen::ConfigPtr m_pending;
+    int m_coalesced = 0;
+};
+
+#endif
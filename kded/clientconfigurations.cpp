@@ -0,0 +1,110 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "clientconfigurations.h"
+#include "../common/control.h"
+#include "kscreen_daemon_debug.h"
+
+#include <QDBusConnection>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace KScreen
+{
+namespace ConfigSerializer
+{
+// Exported private symbol in configserializer_p.h in KScreen
+extern KScreen::ConfigPtr deserializeConfig(const QVariantMap &map);
+}
+}
+
+quint32 ClientConfigurations::generation() const
+{
+    return m_generation;
+}
+
+void ClientConfigurations::switchedTo(const KScreen::ConfigPtr &config)
+{
+    const QString outputsHash = config->connectedOutputsHash();
+    if (outputsHash == m_outputsHash) {
+        return;
+    }
+    m_outputsHash = outputsHash;
+    nextGeneration();
+    drop();
+}
+
+void ClientConfigurations::nextGeneration()
+{
+    if (++m_generation == 0) {
+        // 0 is reserved for rejected configurations.
+        m_generation = 1;
+    }
+}
+
+KScreen::ConfigPtr ClientConfigurations::take(const QString &layout, const QString &control, quint32 generation, const KScreen::ConfigPtr &current)
+{
+    if (!current || generation != m_generation) {
+        qCDebug(KSCREEN_KDED) << "Rejecting configuration of generation" << generation << ", current generation is" << m_generation;
+        return KScreen::ConfigPtr();
+    }
+
+    const QVariantMap layoutMap = QJsonDocument::fromJson(layout.toUtf8()).object().toVariantMap();
+    const KScreen::ConfigPtr config = KScreen::ConfigSerializer::deserializeConfig(layoutMap);
+    if (!config || config->connectedOutputsHash() != current->connectedOutputsHash()) {
+        qCWarning(KSCREEN_KDED) << "Rejecting configuration that does not match the connected outputs";
+        return KScreen::ConfigPtr();
+    }
+    // Keep the backend state that is not decided by the client.
+    config->setSupportedFeatures(current->supportedFeatures());
+    config->setTabletModeAvailable(current->tabletModeAvailable());
+    config->setTabletModeEngaged(current->tabletModeEngaged());
+
+    // Another client's configuration is superseded, it based its changes on the same generation.
+    drop();
+    nextGeneration();
+    m_config = config;
+    m_control = ControlConfig::forConfig(config);
+    m_control->setData(QJsonDocument::fromJson(control.toUtf8()).toVariant().toMap());
+    m_control->writeFile();
+    return config;
+}
+
+void ClientConfigurations::delayReply(const QDBusMessage &reply)
+{
+    m_replies << reply;
+}
+
+bool ClientConfigurations::applyFinished(const KScreen::ConfigPtr &applied, const KScreen::ConfigPtr &current, bool success)
+{
+    if (!m_config) {
+        return false;
+    }
+    // Nothing is pending anymore, if it was not applied it has been replaced.
+    const bool taken = success && applied == m_config && current == m_config;
+    if (!taken) {
+        qCDebug(KSCREEN_KDED) << "Configuration from client was not applied";
+    }
+    finish(taken);
+    return taken;
+}
+
+void ClientConfigurations::drop()
+{
+    if (m_config) {
+        finish(false);
+    }
+}
+
+void ClientConfigurations::finish(bool applied)
+{
+    for (QDBusMessage &reply : m_replies) {
+        reply << (applied ? m_generation : 0u);
+        QDBusConnection::sessionBus().send(reply);
+    }
+    m_replies.clear();
+    m_config.reset();
+    m_control.reset();
+}
@@ -0,0 +1,72 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_CLIENTCONFIGURATIONS_H
+#define KDED_CLIENTCONFIGURATIONS_H
+
+#include <kscreen/config.h>
+
+#include <QDBusMessage>
+#include <QSharedPointer>
+#include <QVector>
+
+class ControlConfig;
+
+/**
+ * Configurations that clients like the KCM hand to the daemon to apply and save.
+ *
+ * A client reads the generation along with the config it bases its changes on. Its configuration
+ * is only taken if it is for the outputs the daemon is at, and no other client's configuration was
+ * taken in the meantime. The reply to the client is held back until its configuration is applied,
+ * so that what the client reads back afterwards is in effect.
+ */
+class ClientConfigurations
+{
+public:
+    /**
+     * Changes whenever the daemon switches to other outputs or takes a client's configuration.
+     */
+    quint32 generation() const;
+    /**
+     * To be called whenever the daemon switches to @p config. If it is for other outputs than
+     * before, the generation changes and the taken configuration is dropped.
+     */
+    void switchedTo(const KScreen::ConfigPtr &config);
+
+    /**
+     * Parses the serialized @p layout and stores its @p control data, unless @p generation is
+     * stale or the layout is not for the outputs of @p current. A configuration taken before that
+     * was not applied yet is dropped.
+     *
+     * @return the config to apply, null if rejected
+     */
+    KScreen::ConfigPtr take(const QString &layout, const QString &control, quint32 generation, const KScreen::ConfigPtr &current);
+    /**
+     * Sends @p reply with the new generation once the taken configuration is applied, or with 0
+     * if it is dropped.
+     */
+    void delayReply(const QDBusMessage &reply);
+
+    /**
+     * Reports that applying @p applied finished, while the daemon is at @p current.
+     *
+     * @return true if the taken configuration was applied and should be saved now
+     */
+    bool applyFinished(const KScreen::ConfigPtr &applied, const KScreen::ConfigPtr &current, bool success);
+    void drop();
+
+private:
+    void nextGeneration();
+    void finish(bool applied);
+
+    quint32 m_generation = 1;
+    QString m_outputsHash;
+    KScreen::ConfigPtr m_config;
+    // Shared with the Config created for m_config, which thus need not read the control files.
+    QSharedPointer<ControlConfig> m_control;
+    QVector<QDBusMessage> m_replies;
+};
+
+#endif
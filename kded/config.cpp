@@ -6,21 +6,36 @@
 */
 #include "config.h"
 #include "../common/control.h"
+#include "../common/fileformat.h"
+#include "../common/flightrecorder.h"
+#include "../common/persistence.h"
+#include "configcache.h"
+#include "configpresets.h"
+#include "configstore.h"
 #include "device.h"
 #include "kscreen_daemon_debug.h"
 #include "output.h"
+#include "outputidentitycache.h"
+#include "storedtopologies.h"
 
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
 #include <QJsonDocument>
+#include <QJsonObject>
 #include <QRect>
 #include <QStandardPaths>
 #include <QStringBuilder>
 
 #include <kscreen/output.h>
 
+#include <algorithm>
+#include <limits>
+
 QString Config::s_fixedConfigFileName = QStringLiteral("fixed-config");
 QString Config::s_configsDirName = QString();
+QString Config::s_openLidSuffix = QStringLiteral("_lidOpened");
 /*QStringLiteral("configs");*/ // TODO: KDE6 - Replace QString w/ QStringLiteral move these files into the subfolder
 
 QString Config::configsDirPath()
@@ -31,7 +46,7 @@ QString Config::configsDirPath()
 Config::Config(KScreen::ConfigPtr config, QObject *parent)
     : QObject(parent)
     , m_data(config)
-    , m_control(new ControlConfig(config, this))
+    , m_control(ControlConfig::forConfig(config))
 {
 }
 
@@ -53,8 +68,8 @@ QString Config::id() const
 
 void Config::activateControlWatching()
 {
-    connect(m_control, &ControlConfig::changed, this, &Config::controlChanged);
-    m_control->activateWatcher();
+    // The shared control watches its files already.
+    connect(m_control.data(), &ControlConfig::changed, this, &Config::controlChanged);
 }
 
 bool Config::autoRotationRequested() const
@@ -110,6 +125,9 @@ void Config::setAutoRotate(bool value)
 
 bool Config::fileExists() const
 {
+    if (auto *store = ConfigStore::self()) {
+        return store->contains(id()) || store->contains(s_fixedConfigFileName);
+    }
     return (QFile::exists(configsDirPath() % id()) || QFile::exists(configsDirPath() % s_fixedConfigFileName));
 }
 
@@ -117,60 +135,181 @@ std::unique_ptr<Config> Config::readFile()
 {
     if (Device::self()->isLaptop() && !Device::self()->isLidClosed()) {
         // We may look for a config that has been set when the lid was closed, Bug: 353029
-        const QString lidOpenedFilePath(filePath() % QStringLiteral("_lidOpened"));
-        const QFile srcFile(lidOpenedFilePath);
-
-        if (srcFile.exists()) {
-            QFile::remove(filePath());
-            if (QFile::copy(lidOpenedFilePath, filePath())) {
-                QFile::remove(lidOpenedFilePath);
-                qCDebug(KSCREEN_KDED) << "Restored lid opened config to" << id();
+        restoreOpenLidConfig();
+    }
+    return readFile(id());
+}
+
+bool Config::dependsOnLid()
+{
+    const KScreen::OutputList outputs = m_data->connectedOutputs();
+    const bool hasPanel = std::any_of(outputs.cbegin(), outputs.cend(), [](const KScreen::OutputPtr &output) {
+        return output->type() == KScreen::Output::Panel;
+    });
+    if (hasPanel) {
+        return true;
+    }
+    return openLidConfigs().contains(id());
+}
+
+QHash<QString, QJsonArray> &Config::openLidConfigs()
+{
+    std::optional<QHash<QString, QJsonArray>> &configs = ConfigCache::self()->openLidConfigs();
+    if (!configs) {
+        configs.emplace();
+        // Left over from a previous run of the daemon that ended while the lid was closed.
+        QStringList fileNames;
+        if (auto *store = ConfigStore::self()) {
+            fileNames = store->keys();
+        } else {
+            fileNames = QDir(configsDirPath()).entryList({QLatin1Char('*') + s_openLidSuffix}, QDir::Files);
+        }
+        for (const QString &fileName : qAsConst(fileNames)) {
+            if (!fileName.endsWith(s_openLidSuffix)) {
+                continue;
+            }
+            if (const auto data = readStoredData(fileName)) {
+                configs->insert(fileName.chopped(s_openLidSuffix.size()), FileFormat::decode(*data).array());
             }
         }
     }
-    return readFile(id());
+    return *configs;
+}
+
+void Config::restoreOpenLidConfig()
+{
+    const QHash<QString, QJsonArray> &configs = openLidConfigs();
+    const auto it = configs.constFind(id());
+    if (it == configs.constEnd()) {
+        return;
+    }
+    // A single atomic write replaces the config, no need to copy the file over.
+    writeOutputsInfo(filePath(), *it);
+    removeData(id() % s_openLidSuffix);
+    qCDebug(KSCREEN_KDED) << "Restored lid opened config to" << id();
 }
 
 std::unique_ptr<Config> Config::readOpenLidFile()
 {
-    const QString openLidFile = id() % QStringLiteral("_lidOpened");
-    auto config = readFile(openLidFile);
-    QFile::remove(configsDirPath() % openLidFile);
+    const QString openLidFile = id() % s_openLidSuffix;
+    const QHash<QString, QJsonArray> &configs = openLidConfigs();
+    const auto it = configs.constFind(id());
+    if (it == configs.constEnd()) {
+        return ConfigCache::self()->fixedConfigExists() ? readFile(openLidFile) : nullptr;
+    }
+    auto config = ConfigCache::self()->fixedConfigExists() ? readFile(openLidFile) : fromOutputs(OutputRecord::listFromJson(*it));
+    removeData(openLidFile);
     return config;
 }
 
+std::optional<QByteArray> Config::readData(const QString &fileName)
+{
+    const bool fixedConfigExists = ConfigStore::self() ? ConfigStore::self()->contains(s_fixedConfigFileName) //
+                                                       : QFile::exists(configsDirPath() % s_fixedConfigFileName);
+    if (fixedConfigExists) {
+        qCDebug(KSCREEN_KDED) << "found a fixed config, will use " << s_fixedConfigFileName;
+        return readStoredData(s_fixedConfigFileName);
+    }
+    return readStoredData(fileName);
+}
+
+std::optional<QByteArray> Config::readStoredData(const QString &fileName)
+{
+    if (auto *store = ConfigStore::self()) {
+        if (!store->contains(fileName)) {
+            qCDebug(KSCREEN_KDED) << "no stored config" << fileName;
+            return std::nullopt;
+        }
+        return store->value(fileName);
+    }
+
+    QFile file(configsDirPath() % fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCDebug(KSCREEN_KDED) << "failed to open file" << file.fileName();
+        return std::nullopt;
+    }
+    return file.readAll();
+}
+
+bool Config::writeData(const QString &filePath, const QByteArray &data)
+{
+    auto *store = ConfigStore::self();
+    if (store && filePath.startsWith(configsDirPath())) {
+        if (!store->insert(filePath.mid(configsDirPath().size()), data)) {
+            return false;
+        }
+        qCDebug(KSCREEN_KDED) << "Config saved in store:" << store->filePath();
+        return true;
+    }
+
+    if (!Persistence::self()->write(filePath, data)) {
+        qCWarning(KSCREEN_KDED) << "Failed to write config file" << filePath;
+        return false;
+    }
+    qCDebug(KSCREEN_KDED) << "Config saved on: " << filePath;
+    return true;
+}
+
+void Config::removeData(const QString &fileName)
+{
+    if (fileName.endsWith(s_openLidSuffix)) {
+        openLidConfigs().remove(fileName.chopped(s_openLidSuffix.size()));
+    }
+    if (auto *store = ConfigStore::self()) {
+        store->remove(fileName);
+    } else {
+        Persistence::self()->remove(configsDirPath() % fileName);
+    }
+    ConfigCache::self()->remove(fileName);
+}
+
 std::unique_ptr<Config> Config::readFile(const QString &fileName)
 {
+    KSCREEN_TRACE_SPAN("io", "readConfig");
     if (!m_data) {
         return nullptr;
     }
-    auto config = std::unique_ptr<Config>(new Config(m_data->clone()));
-    config->setValidityFlags(m_validityFlags);
 
-    QFile file;
-    if (QFile::exists(configsDirPath() % s_fixedConfigFileName)) {
-        file.setFileName(configsDirPath() % s_fixedConfigFileName);
-        qCDebug(KSCREEN_KDED) << "found a fixed config, will use " << file.fileName();
-    } else {
-        file.setFileName(configsDirPath() % fileName);
+    auto *cache = ConfigCache::self();
+    const QString cacheKey = cache->fixedConfigExists() ? s_fixedConfigFileName : fileName;
+    auto outputs = cache->outputs(cacheKey);
+    if (!outputs) {
+        const auto data = readData(fileName);
+        if (!data) {
+            return nullptr;
+        }
+        outputs = OutputRecord::listFromJson(FileFormat::decode(*data).array());
+        cache->insert(cacheKey, *outputs);
     }
-    if (!file.open(QIODevice::ReadOnly)) {
-        qCDebug(KSCREEN_KDED) << "failed to open file" << file.fileName();
+    return fromOutputs(*outputs);
+}
+
+std::unique_ptr<Config> Config::fromOutputs(const QVector<OutputRecord> &outputs)
+{
+    if (!m_data) {
         return nullptr;
     }
+    auto config = std::unique_ptr<Config>(new Config(m_data->clone()));
+    config->setValidityFlags(m_validityFlags);
+    Output::readInOutputs(config->data(), outputs, *config->m_control);
+    updateScreenSize(config->data());
 
-    QJsonDocument parser;
-    QVariantList outputs = parser.fromJson(file.readAll()).toVariant().toList();
-    Output::readInOutputs(config->data(), outputs);
+    if (!canBeApplied(config->data())) {
+        return nullptr;
+    }
+    return config;
+}
 
+void Config::updateScreenSize(const KScreen::ConfigPtr &config)
+{
     QSize screenSize;
-    const auto configOutputs = config->data()->outputs();
+    const auto configOutputs = config->outputs();
     for (const auto &output : configOutputs) {
         if (!output->isPositionable()) {
             continue;
         }
 
-        output->setExplicitLogicalSize(config->data()->logicalSizeForOutput(*output));
+        output->setExplicitLogicalSize(config->logicalSizeForOutput(*output));
 
         const QRect geom = output->geometry();
         if (geom.x() + geom.width() > screenSize.width()) {
@@ -180,11 +319,229 @@ std::unique_ptr<Config> Config::readFile(const QString &fileName)
             screenSize.setHeight(geom.y() + geom.height());
         }
     }
-    config->data()->screen()->setCurrentSize(screenSize);
+    config->screen()->setCurrentSize(screenSize);
+}
 
-    if (!canBeApplied(config->data())) {
+QStringList Config::storedConfigNames()
+{
+    QStringList names;
+    if (auto *store = ConfigStore::self()) {
+        names = store->keys();
+    } else {
+        const auto fileInfos = QDir(configsDirPath()).entryInfoList(QDir::Files);
+        for (const QFileInfo &fileInfo : fileInfos) {
+            // The file of a previously enabled store is left alone.
+            if (fileInfo.fileName() != ConfigStore::fileName()) {
+                names << fileInfo.fileName();
+            }
+        }
+    }
+    names.removeAll(s_fixedConfigFileName);
+    return names;
+}
+
+std::optional<QVector<OutputRecord>> Config::storedOutputs(const QString &fileName)
+{
+    // Taken from the cache if there, but not inserted into it: unlike the config to apply, what
+    // is read here is only looked at once.
+    if (auto outputs = ConfigCache::self()->outputs(fileName)) {
+        return outputs;
+    }
+    const auto data = readStoredData(fileName);
+    if (!data) {
+        return std::nullopt;
+    }
+    return OutputRecord::listFromJson(FileFormat::decode(*data).array());
+}
+
+namespace
+{
+struct TopologyMatch {
+    QString name;
+    // The stored entries for the connected outputs, nullptr where there is none.
+    QVector<const OutputRecord *> records;
+    int matched = 0;
+    int matchedEnabled = 0;
+    int unmatchedStored = 0;
+
+    bool isBetterThan(const TopologyMatch &other) const
+    {
+        if (matched != other.matched) {
+            return matched > other.matched;
+        }
+        if (matchedEnabled != other.matchedEnabled) {
+            return matchedEnabled > other.matchedEnabled;
+        }
+        if (unmatchedStored != other.unmatchedStored) {
+            return unmatchedStored < other.unmatchedStored;
+        }
+        return name < other.name;
+    }
+};
+}
+
+static TopologyMatch matchTopology(const QList<KScreen::OutputPtr> &connectedOutputs, const QString &name, const QVector<OutputRecord> &records)
+{
+    TopologyMatch match;
+    match.name = name;
+    match.records.fill(nullptr, connectedOutputs.size());
+    QVector<bool> used(records.size(), false);
+
+    // Identical outputs share an id, prefer the entry of the same connector for them.
+    for (const bool sameName : {true, false}) {
+        for (int i = 0; i < connectedOutputs.size(); ++i) {
+            if (match.records.at(i)) {
+                continue;
+            }
+            const KScreen::OutputPtr &output = connectedOutputs.at(i);
+            for (int j = 0; j < records.size(); ++j) {
+                if (used.at(j) || records.at(j).id != OutputIdentityCache::self()->hash(output) || (sameName && records.at(j).name != output->name())) {
+                    continue;
+                }
+                used[j] = true;
+                match.records[i] = &records.at(j);
+                match.matched++;
+                match.matchedEnabled += records.at(j).enabled ? 1 : 0;
+                break;
+            }
+        }
+    }
+    match.unmatchedStored = records.size() - match.matched;
+    return match;
+}
+
+// Moves the enabled outputs next to each other from left to right, keeping their order and
+// vertical positions, where outputs of the stored config are missing in between.
+static int closeGaps(const QList<KScreen::OutputPtr> &outputs)
+{
+    QList<KScreen::OutputPtr> sorted;
+    int minX = std::numeric_limits<int>::max();
+    int minY = std::numeric_limits<int>::max();
+    for (const auto &output : outputs) {
+        if (output->isPositionable()) {
+            sorted << output;
+            minX = std::min(minX, output->pos().x());
+            minY = std::min(minY, output->pos().y());
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const KScreen::OutputPtr &a, const KScreen::OutputPtr &b) {
+        return a->pos().x() < b->pos().x();
+    });
+
+    int shift = minX;
+    int right = 0;
+    for (const auto &output : qAsConst(sorted)) {
+        int x = output->pos().x() - shift;
+        if (x > right) {
+            shift += x - right;
+            x = right;
+        }
+        output->setPos(QPoint(x, output->pos().y() - minY));
+        right = std::max(right, output->geometry().x() + output->geometry().width());
+    }
+    return right;
+}
+
+std::unique_ptr<Config> Config::readPresetFile()
+{
+    if (!m_data) {
+        return nullptr;
+    }
+    const auto outputs = ConfigPresets::self()->outputs(m_data->outputs());
+    if (!outputs) {
+        return nullptr;
+    }
+    return fromOutputs(*outputs);
+}
+
+std::unique_ptr<Config> Config::readNearestFile()
+{
+    if (!m_data) {
+        return nullptr;
+    }
+    const QList<KScreen::OutputPtr> connectedOutputs = m_data->connectedOutputs().values();
+    if (connectedOutputs.isEmpty()) {
+        return nullptr;
+    }
+
+    // The match points into the stored outputs.
+    const QHash<QString, QVector<OutputRecord>> storedTopologies = StoredTopologies::self()->outputs();
+    std::optional<TopologyMatch> best;
+    for (auto it = storedTopologies.constBegin(); it != storedTopologies.constEnd(); ++it) {
+        if (it.key().endsWith(s_openLidSuffix) || it.key() == id() || it->isEmpty()) {
+            continue;
+        }
+        TopologyMatch match = matchTopology(connectedOutputs, it.key(), *it);
+        if (!best || match.isBetterThan(*best)) {
+            best = std::move(match);
+        }
+    }
+
+    // Good enough is a stored config with all the connected outputs, or with all but one of
+    // them if it shares at least two. A single new output next to a single known one is better
+    // left to the user.
+    const int unmatched = best ? connectedOutputs.size() - best->matched : 0;
+    if (!best || best->matchedEnabled == 0 || (unmatched > 1) || (unmatched == 1 && best->matched < 2)) {
+        qCDebug(KSCREEN_KDED) << "No stored config is close enough to" << id();
+        return nullptr;
+    }
+    qCDebug(KSCREEN_KDED) << "Deriving config for" << id() << "from" << best->name << "matching" << best->matched << "outputs";
+    // The index only has what is needed for matching, match again against all that is stored.
+    const auto bestRecords = storedOutputs(best->name);
+    if (!bestRecords) {
+        return nullptr;
+    }
+    best = matchTopology(connectedOutputs, best->name, *bestRecords);
+
+    QVector<OutputRecord> outputs;
+    QStringList newOutputs;
+    bool hasPrimary = false;
+    for (int i = 0; i < connectedOutputs.size(); ++i) {
+        if (const OutputRecord *record = best->records.at(i)) {
+            outputs << *record;
+            hasPrimary |= record->primary;
+            continue;
+        }
+        OutputRecord record;
+        record.id = OutputIdentityCache::self()->hash(connectedOutputs.at(i));
+        record.name = connectedOutputs.at(i)->name();
+        record.enabled = true;
+        outputs << record;
+        newOutputs << record.name;
+    }
+    if (!hasPrimary) {
+        // The primary output is among the ones that are gone.
+        for (auto &record : outputs) {
+            if (record.enabled && !newOutputs.contains(record.name)) {
+                record.primary = true;
+                break;
+            }
+        }
+    }
+
+    auto config = fromOutputs(outputs);
+    if (!config) {
         return nullptr;
     }
+
+    QList<KScreen::OutputPtr> knownOutputs;
+    QList<KScreen::OutputPtr> addedOutputs;
+    const auto configOutputs = config->data()->outputs();
+    for (const auto &output : configOutputs) {
+        if (output->isConnected()) {
+            (newOutputs.contains(output->name()) ? addedOutputs : knownOutputs) << output;
+        }
+    }
+    // New outputs extend the known layout to the right.
+    int right = closeGaps(knownOutputs);
+    for (const auto &output : qAsConst(addedOutputs)) {
+        if (!output->isPositionable()) {
+            continue;
+        }
+        output->setPos(QPoint(right, 0));
+        right += output->geometry().width();
+    }
+    updateScreenSize(config->data());
     return config;
 }
 
@@ -210,30 +567,46 @@ bool Config::writeFile()
 
 bool Config::writeOpenLidFile()
 {
-    return writeFile(filePath() % QStringLiteral("_lidOpened"));
+    if (id().isEmpty()) {
+        return false;
+    }
+    const QJsonArray outputsInfo = this->outputsInfo();
+    openLidConfigs().insert(id(), outputsInfo);
+    // Persisted only in case the daemon does not survive until the lid is opened again.
+    return writeOutputsInfo(filePath() % s_openLidSuffix, outputsInfo);
 }
 
 bool Config::writeFile(const QString &filePath)
 {
+    KSCREEN_TRACE_SPAN("io", "writeConfig");
     if (id().isEmpty()) {
         return false;
     }
+    return writeOutputsInfo(filePath, outputsInfo());
+}
+
+QJsonArray Config::outputsInfo()
+{
     const KScreen::OutputList outputs = m_data->outputs();
 
     const auto oldConfig = readFile();
-    KScreen::OutputList oldOutputs;
+    // The first old output by hash, each hashed once.
+    QHash<QString, KScreen::OutputPtr> oldOutputs;
     if (oldConfig) {
-        oldOutputs = oldConfig->data()->outputs();
+        const KScreen::OutputList oldConfigOutputs = oldConfig->data()->outputs();
+        for (const KScreen::OutputPtr &oldOutput : oldConfigOutputs) {
+            const QString hash = OutputIdentityCache::self()->hashMd5(oldOutput);
+            if (!oldOutputs.contains(hash)) {
+                oldOutputs.insert(hash, oldOutput);
+            }
+        }
     }
 
-    QVariantList outputList;
+    QJsonArray outputList;
     for (const KScreen::OutputPtr &output : outputs) {
-        QVariantMap info;
+        QJsonObject info;
 
-        const auto oldOutputIt = std::find_if(oldOutputs.constBegin(), oldOutputs.constEnd(), [output](const KScreen::OutputPtr &out) {
-            return out->hashMd5() == output->hashMd5();
-        });
-        const KScreen::OutputPtr oldOutput = oldOutputIt != oldOutputs.constEnd() ? *oldOutputIt : nullptr;
+        const KScreen::OutputPtr oldOutput = oldOutputs.value(OutputIdentityCache::self()->hashMd5(output));
 
         if (!output->isConnected()) {
             continue;
@@ -248,29 +621,32 @@ bool Config::writeFile(const QString &filePath)
                 return;
             }
 
-            QVariantMap pos;
+            QJsonObject pos;
             pos[QStringLiteral("x")] = out->pos().x();
             pos[QStringLiteral("y")] = out->pos().y();
             info[QStringLiteral("pos")] = pos;
         };
         setOutputConfigInfo(output->isEnabled() ? output : oldOutput);
 
-        if (output->isEnabled() && m_control->getOutputRetention(output->hash(), output->name()) != Control::OutputRetention::Individual) {
+        if (output->isEnabled() && m_control->getOutputRetention(OutputIdentityCache::self()->hash(output), output->name()) != Control::OutputRetention::Individual) {
             // try to update global output data
             Output::writeGlobal(output);
         }
 
         outputList.append(info);
     }
+    return outputList;
+}
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        qCWarning(KSCREEN_KDED) << "Failed to open config file for writing! " << file.errorString();
+bool Config::writeOutputsInfo(const QString &filePath, const QJsonArray &outputsInfo)
+{
+    if (!writeData(filePath, FileFormat::encode(QJsonDocument(outputsInfo)))) {
         return false;
     }
-    file.write(QJsonDocument::fromVariant(outputList).toJson());
-    qCDebug(KSCREEN_KDED) << "Config saved on: " << file.fileName();
-
+    if (filePath.startsWith(configsDirPath())) {
+        // Cache what a reader would parse back from the file.
+        ConfigCache::self()->insertWritten(filePath.mid(configsDirPath().size()), OutputRecord::listFromJson(outputsInfo));
+    }
     return true;
 }
 
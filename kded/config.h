@@ -6,11 +6,18 @@
 #ifndef KDED_CONFIG_H
 #define KDED_CONFIG_H
 
+#include "output.h"
+
 #include <kscreen/config.h>
 
+#include <QHash>
+#include <QJsonArray>
 #include <QOrientationReading>
+#include <QSharedPointer>
+#include <QVector>
 
 #include <memory>
+#include <optional>
 
 class ControlConfig;
 
@@ -25,9 +32,25 @@ public:
 
     bool fileExists() const;
     std::unique_ptr<Config> readFile();
+    /**
+     * Whether readFile() and applying its result depend on the lid state, which is only known
+     * once Device is ready.
+     */
+    bool dependsOnLid();
     std::unique_ptr<Config> readOpenLidFile();
     bool writeFile();
     bool writeOpenLidFile();
+    /**
+     * Reads the layout preset of the administrator for the connected outputs, see ConfigPresets.
+     */
+    std::unique_ptr<Config> readPresetFile();
+    /**
+     * Synthesizes a config from the stored config whose outputs match the connected outputs
+     * best, for when there is no stored config for them.
+     *
+     * @return nullptr if no stored config is close enough
+     */
+    std::unique_ptr<Config> readNearestFile();
     static QString configsDirPath();
 
     KScreen::ConfigPtr data() const
@@ -54,19 +77,43 @@ Q_SIGNALS:
 
 private:
     friend class TestConfig;
+    friend class ConfigCache;
+    friend class ConfigCompactor;
+    friend class StoredTopologies;
+    friend class TopologyCache;
 
     QString filePath() const;
     std::unique_ptr<Config> readFile(const QString &fileName);
+    std::unique_ptr<Config> fromOutputs(const QVector<OutputRecord> &outputs);
+    static void updateScreenSize(const KScreen::ConfigPtr &config);
     bool writeFile(const QString &filePath);
+    QJsonArray outputsInfo();
+    bool writeOutputsInfo(const QString &filePath, const QJsonArray &outputsInfo);
+    void restoreOpenLidConfig();
+    /**
+     * The configs saved when the lid was closed, by id. They are also written to disk, but only
+     * read back from there once per ConfigCache, in case the daemon was restarted in the meantime.
+     */
+    static QHash<QString, QJsonArray> &openLidConfigs();
+    static std::optional<QByteArray> readData(const QString &fileName);
+    static std::optional<QByteArray> readStoredData(const QString &fileName);
+    static bool writeData(const QString &filePath, const QByteArray &data);
+    static void removeData(const QString &fileName);
+    /**
+     * The names of all stored configs, without the fixed config.
+     */
+    static QStringList storedConfigNames();
+    static std::optional<QVector<OutputRecord>> storedOutputs(const QString &fileName);
 
     bool canBeApplied(KScreen::ConfigPtr config) const;
 
     KScreen::ConfigPtr m_data;
     KScreen::Config::ValidityFlags m_validityFlags;
-    ControlConfig *m_control;
+    QSharedPointer<ControlConfig> m_control;
 
     static QString s_configsDirName;
     static QString s_fixedConfigFileName;
+    static QString s_openLidSuffix;
 
 };
 
@@ -0,0 +1,199 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "configcache.h"
+#include "../common/fileformat.h"
+#include "../common/flightrecorder.h"
+#include "config.h"
+#include "configstore.h"
+#include "kscreen_daemon_debug.h"
+
+#include <KDirWatch>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <QStringBuilder>
+
+// QSaveFile's temporary file next to the file being written
+static const QRegularExpression s_temporaryFileName(QStringLiteral("\\.[A-Za-z0-9]{6}$"));
+
+ConfigCache::ConfigCache()
+    : QObject()
+{
+    if (ConfigStore::isEnabled()) {
+        // The store is only written through Config, which keeps us up to date.
+        return;
+    }
+    m_fixedConfigExists = QFile::exists(Config::configsDirPath() % Config::s_fixedConfigFileName);
+    m_watcher = new KDirWatch(this);
+    m_watcher->addDir(Config::configsDirPath(), KDirWatch::WatchFiles);
+    connect(m_watcher, &KDirWatch::dirty, this, &ConfigCache::fileChanged);
+    connect(m_watcher, &KDirWatch::created, this, &ConfigCache::fileChanged);
+    connect(m_watcher, &KDirWatch::deleted, this, &ConfigCache::fileChanged);
+    connect(Persistence::self(), &Persistence::written, this, &ConfigCache::fileWritten);
+}
+
+ConfigCache::~ConfigCache()
+{
+    m_prefetchPool.waitForDone();
+    qCDebug(KSCREEN_KDED) << "Config cache hits:" << m_hits << "misses:" << m_misses;
+}
+
+std::optional<QVector<OutputRecord>> ConfigCache::outputs(const QString &fileName)
+{
+    const auto it = m_entries.constFind(fileName);
+    if (it == m_entries.constEnd()) {
+        m_misses++;
+        qCDebug(KSCREEN_KDED) << "Config cache miss for" << fileName << "- hits:" << m_hits << "misses:" << m_misses;
+        return std::nullopt;
+    }
+    m_hits++;
+    qCDebug(KSCREEN_KDED) << "Config cache hit for" << fileName << "- hits:" << m_hits << "misses:" << m_misses;
+    return it->outputs;
+}
+
+void ConfigCache::insert(const QString &fileName, const QVector<OutputRecord> &outputs)
+{
+    Entry entry;
+    entry.outputs = outputs;
+    if (m_watcher) {
+        // Remember what the file looked like, so that only later changes drop the entry again.
+        entry.stamp = FileStamp::of(QFileInfo(Config::configsDirPath() % fileName));
+    }
+    m_entries.insert(fileName, entry);
+    if (fileName == Config::s_fixedConfigFileName) {
+        m_fixedConfigExists = true;
+    }
+}
+
+void ConfigCache::insertWritten(const QString &fileName, const QVector<OutputRecord> &outputs)
+{
+    if (!m_watcher || !Persistence::self()->isAsynchronous()) {
+        insert(fileName, outputs);
+    } else {
+        Entry entry;
+        entry.outputs = outputs;
+        m_entries.insert(fileName, entry);
+        if (fileName == Config::s_fixedConfigFileName) {
+            m_fixedConfigExists = true;
+        }
+    }
+    Q_EMIT storedConfigWritten(fileName);
+}
+
+void ConfigCache::prefetch(const QStringList &fileNames)
+{
+    if (!m_watcher || fileNames.isEmpty()) {
+        // The indexed store reads its records on demand.
+        return;
+    }
+    // A fixed config is read instead of any other.
+    const QStringList names = m_fixedConfigExists ? QStringList{Config::s_fixedConfigFileName} : fileNames;
+    m_prefetchPool.start([this, fileNames = names, dirPath = Config::configsDirPath()]() {
+        KSCREEN_TRACE_SPAN("io", "prefetchConfigs");
+        for (const QString &fileName : fileNames) {
+            const QString filePath = dirPath % fileName;
+            const FileStamp stamp = FileStamp::of(QFileInfo(filePath));
+            QFile file(filePath);
+            if (!file.open(QIODevice::ReadOnly)) {
+                continue;
+            }
+            const QVector<OutputRecord> outputs = OutputRecord::listFromJson(FileFormat::decode(file.readAll()).array());
+            QMetaObject::invokeMethod(
+                this,
+                [this, fileName, filePath, stamp, outputs]() {
+                    if (m_entries.contains(fileName)) {
+                        return;
+                    }
+                    // Only take what was read if the file was not changed since.
+                    if (FileStamp::of(QFileInfo(filePath)) == stamp) {
+                        qCDebug(KSCREEN_KDED) << "Prefetched stored config" << fileName;
+                        insert(fileName, outputs);
+                    }
+                },
+                Qt::QueuedConnection);
+        }
+    });
+}
+
+void ConfigCache::remove(const QString &fileName)
+{
+    m_entries.remove(fileName);
+    Q_EMIT storedConfigWritten(fileName);
+}
+
+void ConfigCache::clear()
+{
+    m_entries.clear();
+}
+
+bool ConfigCache::fixedConfigExists() const
+{
+    if (auto *store = ConfigStore::self()) {
+        return store->contains(Config::s_fixedConfigFileName);
+    }
+    return m_fixedConfigExists;
+}
+
+void ConfigCache::fileChanged(const QString &path)
+{
+    const QFileInfo fileInfo(path);
+    if (fileInfo.isDir() || QDir::cleanPath(path) == QDir::cleanPath(Config::configsDirPath())) {
+        // The directory changes with every file written into it, our own included. The files
+        // report their changes themselves.
+        return;
+    }
+    const QString fileName = fileInfo.fileName();
+    if (fileName.startsWith(QLatin1Char('.'))) {
+        // Bookkeeping of the daemon, not a config.
+        return;
+    }
+    if (s_temporaryFileName.match(fileName).hasMatch()) {
+        // Where QSaveFile writes a file before renaming it into place.
+        return;
+    }
+    if (Persistence::self()->isPending(Config::configsDirPath() % fileName)) {
+        // Our own write, the cache is already up to date with it.
+        return;
+    }
+    if (fileName == Config::s_fixedConfigFileName) {
+        // A fixed config overrides all others.
+        m_fixedConfigExists = fileInfo.exists();
+        qCDebug(KSCREEN_KDED) << "Fixed config changed, clearing config cache";
+        clear();
+        Q_EMIT storedConfigsChanged(QString());
+        return;
+    }
+    const auto it = m_entries.constFind(fileName);
+    if (it != m_entries.constEnd()) {
+        if (fileInfo.exists() && FileStamp::of(fileInfo) == it->stamp) {
+            return;
+        }
+        qCDebug(KSCREEN_KDED) << "Stored config" << fileName << "changed, dropping it from the config cache";
+        m_entries.remove(fileName);
+    }
+    Q_EMIT storedConfigsChanged(fileName);
+}
+
+void ConfigCache::fileWritten(const QString &path, bool success)
+{
+    if (!path.startsWith(Config::configsDirPath())) {
+        return;
+    }
+    const auto it = m_entries.find(path.mid(Config::configsDirPath().size()));
+    if (it == m_entries.end() || Persistence::self()->isPending(path)) {
+        // Wait for the last of our writes to the file.
+        return;
+    }
+    if (!success) {
+        m_entries.erase(it);
+        return;
+    }
+    it->stamp = FileStamp::of(QFileInfo(path));
+}
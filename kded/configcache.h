@@ -0,0 +1,97 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_CONFIGCACHE_H
+#define KDED_CONFIGCACHE_H
+
+#include "../common/persistence.h"
+#include "../common/singleton.h"
+#include "output.h"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+
+#include <optional>
+
+class KDirWatch;
+
+/**
+ * Per-process cache of parsed stored configs, keyed by config file name (usually Config::id()).
+ *
+ * Entries are dropped when the backing file is changed by someone else, as reported by a
+ * directory watcher on Config::configsDirPath(). Writes of the daemon itself update the cache
+ * in place, so repeated apply and save cycles do not need to read back what was just written.
+ */
+class ConfigCache : public QObject, public Singleton<ConfigCache>
+{
+    Q_OBJECT
+public:
+    std::optional<QVector<OutputRecord>> outputs(const QString &fileName);
+    /**
+     * Caches @p outputs as read from the stored config @p fileName.
+     */
+    void insert(const QString &fileName, const QVector<OutputRecord> &outputs);
+    /**
+     * Caches @p outputs which were just handed to Persistence for writing to @p fileName.
+     */
+    void insertWritten(const QString &fileName, const QVector<OutputRecord> &outputs);
+    /**
+     * Reads and parses the stored configs @p fileNames in the background, so that a config
+     * likely to be read soon is ready by then.
+     */
+    void prefetch(const QStringList &fileNames);
+    void remove(const QString &fileName);
+    void clear();
+
+    /**
+     * Whether a fixed config exists, which then overrides all other configs.
+     */
+    bool fixedConfigExists() const;
+
+    /**
+     * Storage of Config::openLidConfigs(), unset until Config loaded them.
+     */
+    std::optional<QHash<QString, QJsonArray>> &openLidConfigs()
+    {
+        return m_openLidConfigs;
+    }
+
+Q_SIGNALS:
+    /**
+     * Emitted when the stored config @p fileName was changed by someone else than the daemon.
+     * @p fileName is empty when all of them might have changed, as the fixed config did.
+     */
+    void storedConfigsChanged(const QString &fileName);
+    /**
+     * Emitted when the daemon itself wrote or removed the stored config @p fileName.
+     */
+    void storedConfigWritten(const QString &fileName);
+
+private:
+    friend class Singleton<ConfigCache>;
+    explicit ConfigCache();
+    ~ConfigCache() override;
+
+    void fileChanged(const QString &path);
+    void fileWritten(const QString &path, bool success);
+
+    struct Entry {
+        QVector<OutputRecord> outputs;
+        // Of the file the outputs are in, invalid until our own write of them is done.
+        FileStamp stamp;
+    };
+    QHash<QString, Entry> m_entries;
+    KDirWatch *m_watcher = nullptr;
+    QThreadPool m_prefetchPool;
+    bool m_fixedConfigExists = false;
+    std::optional<QHash<QString, QJsonArray>> m_openLidConfigs;
+    int m_hits = 0;
+    int m_misses = 0;
+};
+
+#endif
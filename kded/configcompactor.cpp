@@ -0,0 +1,183 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "configcompactor.h"
+#include "../common/control.h"
+#include "../common/fileformat.h"
+#include "../common/persistence.h"
+#include "config.h"
+#include "configstore.h"
+#include "kscreen_daemon_debug.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QStringBuilder>
+#include <QVector>
+
+#include <algorithm>
+
+static const QString s_lidOpenedSuffix = QStringLiteral("_lidOpened");
+// Only persist a new usage time if the stored one is older, to not write on every apply.
+static const qint64 s_usageResolutionSecs = 60 * 60;
+
+ConfigCompactor::ConfigCompactor()
+{
+    readUsage();
+}
+
+void ConfigCompactor::setLimits(const Limits &limits)
+{
+    m_limits = limits;
+}
+
+QString ConfigCompactor::usageFilePath() const
+{
+    return Config::configsDirPath() % QStringLiteral(".usage");
+}
+
+void ConfigCompactor::readUsage()
+{
+    QFile file(usageFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QJsonObject usage = FileFormat::decode(file.readAll()).object();
+    for (auto it = usage.constBegin(); it != usage.constEnd(); ++it) {
+        m_lastUsed.insert(it.key(), QDateTime::fromSecsSinceEpoch(it.value().toVariant().toLongLong()));
+    }
+}
+
+void ConfigCompactor::writeUsage()
+{
+    QJsonObject usage;
+    for (auto it = m_lastUsed.constBegin(); it != m_lastUsed.constEnd(); ++it) {
+        usage.insert(it.key(), it.value().toSecsSinceEpoch());
+    }
+    Persistence::self()->write(usageFilePath(), FileFormat::encode(QJsonDocument(usage)));
+}
+
+void ConfigCompactor::markUsed(const QString &id)
+{
+    if (id.isEmpty()) {
+        return;
+    }
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const auto it = m_lastUsed.constFind(id);
+    if (it != m_lastUsed.constEnd() && it->secsTo(now) < s_usageResolutionSecs) {
+        return;
+    }
+    m_lastUsed.insert(id, now);
+    writeUsage();
+}
+
+QStringList ConfigCompactor::recentlyUsed(int count) const
+{
+    QStringList names = m_lastUsed.keys();
+    std::sort(names.begin(), names.end(), [this](const QString &a, const QString &b) {
+        return m_lastUsed.value(a) > m_lastUsed.value(b);
+    });
+    return names.mid(0, count);
+}
+
+void ConfigCompactor::removeConfig(const QString &name)
+{
+    Config::removeData(name);
+    if (!name.endsWith(s_lidOpenedSuffix)) {
+        Persistence::self()->remove(ControlConfig::configsDirPath() % name);
+    }
+}
+
+int ConfigCompactor::compact(const QString &activeId)
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const QStringList names = Config::storedConfigNames();
+
+    QHash<QString, QDateTime> lastUsed;
+    lastUsed.reserve(names.size());
+    for (const QString &name : names) {
+        QDateTime time = m_lastUsed.value(name);
+        if (!time.isValid() && !ConfigStore::self()) {
+            // Configs from before usage tracking.
+            time = QFileInfo(Config::configsDirPath() % name).lastModified().toUTC();
+        }
+        if (!time.isValid()) {
+            time = now;
+            m_lastUsed.insert(name, now);
+        }
+        lastUsed.insert(name, time);
+    }
+
+    const QStringList evicted = evictions(lastUsed, activeId, now, m_limits);
+    for (const QString &name : evicted) {
+        qCDebug(KSCREEN_KDED) << "Removing stale config" << name << "last used" << lastUsed.value(name);
+        removeConfig(name);
+    }
+
+    // Forget about configs that are gone, however they were removed.
+    const QSet<QString> remaining = QSet<QString>(names.cbegin(), names.cend()).subtract(QSet<QString>(evicted.cbegin(), evicted.cend()));
+    for (auto it = m_lastUsed.begin(); it != m_lastUsed.end();) {
+        if (!remaining.contains(it.key()) && it.key() != activeId) {
+            it = m_lastUsed.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    writeUsage();
+
+    if (!evicted.isEmpty()) {
+        if (auto *store = ConfigStore::self()) {
+            store->compact();
+        }
+    }
+    qCDebug(KSCREEN_KDED) << "Config compaction removed" << evicted.size() << "of" << names.size() << "stored configs";
+    return evicted.size();
+}
+
+QStringList ConfigCompactor::evictions(const QHash<QString, QDateTime> &lastUsed, const QString &activeId, const QDateTime &now, const Limits &limits)
+{
+    QStringList evicted;
+    QVector<QString> candidates;
+    for (auto it = lastUsed.constBegin(); it != lastUsed.constEnd(); ++it) {
+        const QString &name = it.key();
+        if (name.endsWith(s_lidOpenedSuffix)) {
+            // Only useful while the same outputs are connected.
+            if (name.chopped(s_lidOpenedSuffix.size()) != activeId && it->daysTo(now) > limits.lidOpenedMaxAgeDays) {
+                evicted << name;
+            }
+            continue;
+        }
+        if (name == activeId) {
+            continue;
+        }
+        if (it->daysTo(now) > limits.maxAgeDays) {
+            evicted << name;
+            continue;
+        }
+        candidates << name;
+    }
+
+    // The active config counts against the limit.
+    const int maxCandidates = std::max(0, limits.maxCount - (lastUsed.contains(activeId) ? 1 : 0));
+    if (candidates.size() > maxCandidates) {
+        std::sort(candidates.begin(), candidates.end(), [&lastUsed](const QString &a, const QString &b) {
+            return lastUsed.value(a) > lastUsed.value(b);
+        });
+        for (int i = maxCandidates; i < candidates.size(); ++i) {
+            evicted << candidates.at(i);
+        }
+    }
+
+    // Without its config the "_lidOpened" config of the same outputs is useless too.
+    for (int i = 0, count = evicted.size(); i < count; ++i) {
+        const QString lidOpened = evicted.at(i) % s_lidOpenedSuffix;
+        if (!evicted.at(i).endsWith(s_lidOpenedSuffix) && lastUsed.contains(lidOpened) && !evicted.contains(lidOpened)) {
+            evicted << lidOpened;
+        }
+    }
+    return evicted;
+}
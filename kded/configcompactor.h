@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_CONFIGCOMPACTOR_H
+#define KDED_CONFIGCOMPACTOR_H
+
+#include "../common/singleton.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Keeps the number of stored configs bounded.
+ *
+ * A config is stored for every combination of outputs ever connected. The compactor tracks when
+ * each of them was last used and removes the ones that were not used for a long time or exceed
+ * the maximum count, least recently used first, together with their control files. Leftover
+ * "_lidOpened" configs of other output combinations are removed as well. The active config is
+ * never removed.
+ *
+ * The usage times are kept in a hidden file next to the configs.
+ */
+class ConfigCompactor : public Singleton<ConfigCompactor>
+{
+public:
+    struct Limits {
+        int maxCount = 64;
+        int maxAgeDays = 365;
+        // "_lidOpened" configs are read back when the lid opens with the same outputs connected.
+        int lidOpenedMaxAgeDays = 7;
+    };
+
+    void setLimits(const Limits &limits);
+
+    /**
+     * Records that the config @p id is in use now.
+     */
+    void markUsed(const QString &id);
+    /**
+     * The @p count configs used most recently, most recent first.
+     */
+    QStringList recentlyUsed(int count) const;
+
+    /**
+     * Removes stale configs, but never @p activeId.
+     * @returns the number of removed configs
+     */
+    int compact(const QString &activeId);
+
+    /**
+     * Selects the configs to remove from @p lastUsed, which maps the stored config names to the time
+     * they were last used.
+     */
+    static QStringList evictions(const QHash<QString, QDateTime> &lastUsed, const QString &activeId, const QDateTime &now, const Limits &limits);
+
+private:
+    friend class Singleton<ConfigCompactor>;
+    ConfigCompactor();
+
+    QString usageFilePath() const;
+    void readUsage();
+    void writeUsage();
+    void removeConfig(const QString &name);
+
+    Limits m_limits;
+    QHash<QString, QDateTime> m_lastUsed;
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "configdelta.h"
+
+#include <kscreen/output.h>
+
+#include <QDebug>
+
+static ConfigDelta::Changes outputChanges(const KScreen::OutputPtr &live, const KScreen::OutputPtr &desired)
+{
+    using Change = ConfigDelta::Change;
+    ConfigDelta::Changes changes;
+    if (live->isEnabled() != desired->isEnabled()) {
+        changes |= Change::Enabled;
+    }
+    if (live->isPrimary() != desired->isPrimary()) {
+        changes |= Change::Primary;
+    }
+    if (!desired->isEnabled()) {
+        // Nothing else of a disabled output is applied.
+        return changes;
+    }
+    if (live->currentModeId() != desired->currentModeId()) {
+        changes |= Change::Mode;
+    }
+    if (live->pos() != desired->pos()) {
+        changes |= Change::Position;
+    }
+    if (!qFuzzyCompare(live->scale(), desired->scale())) {
+        changes |= Change::Scale;
+    }
+    if (live->rotation() != desired->rotation()) {
+        changes |= Change::Rotation;
+    }
+    if (live->vrrPolicy() != desired->vrrPolicy()) {
+        changes |= Change::VrrPolicy;
+    }
+    if (live->overscan() != desired->overscan()) {
+        changes |= Change::Overscan;
+    }
+    if (live->rgbRange() != desired->rgbRange()) {
+        changes |= Change::RgbRange;
+    }
+    if (live->replicationSource() != desired->replicationSource()) {
+        changes |= Change::Replication;
+    }
+    return changes;
+}
+
+ConfigDelta ConfigDelta::compute(const KScreen::ConfigPtr &live, const KScreen::ConfigPtr &desired)
+{
+    ConfigDelta delta;
+    const KScreen::OutputList liveOutputs = live->outputs();
+    const KScreen::OutputList desiredOutputs = desired->outputs();
+    for (const KScreen::OutputPtr &desiredOutput : desiredOutputs) {
+        if (!desiredOutput->isConnected()) {
+            continue;
+        }
+        const KScreen::OutputPtr liveOutput = liveOutputs.value(desiredOutput->id());
+        const Changes changes = liveOutput ? outputChanges(liveOutput, desiredOutput) : Changes(Change::Output);
+        if (changes) {
+            delta.m_outputs.insert(desiredOutput->id(), changes);
+        }
+    }
+    return delta;
+}
+
+bool ConfigDelta::isEmpty() const
+{
+    return m_outputs.isEmpty();
+}
+
+QHash<int, ConfigDelta::Changes> ConfigDelta::outputs() const
+{
+    return m_outputs;
+}
+
+QDebug operator<<(QDebug dbg, const ConfigDelta &delta)
+{
+    QDebugStateSaver saver(dbg);
+    dbg.nospace() << "ConfigDelta(";
+    const auto outputs = delta.outputs();
+    for (auto it = outputs.constBegin(); it != outputs.constEnd(); ++it) {
+        dbg << it.key() << ": " << static_cast<int>(it.value()) << ", ";
+    }
+    dbg << ")";
+    return dbg;
+}
@@ -0,0 +1,54 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_CONFIGDELTA_H
+#define KDED_CONFIGDELTA_H
+
+#include <kscreen/config.h>
+
+#include <QFlags>
+#include <QHash>
+
+class QDebug;
+
+/**
+ * The per-output differences between the config live in the backend and a config to apply.
+ */
+class ConfigDelta
+{
+public:
+    enum class Change {
+        Mode = 1 << 0,
+        Position = 1 << 1,
+        Scale = 1 << 2,
+        Rotation = 1 << 3,
+        Enabled = 1 << 4,
+        Primary = 1 << 5,
+        VrrPolicy = 1 << 6,
+        Overscan = 1 << 7,
+        RgbRange = 1 << 8,
+        Replication = 1 << 9,
+        // The output is not known to the live config.
+        Output = 1 << 10,
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
+
+    static ConfigDelta compute(const KScreen::ConfigPtr &live, const KScreen::ConfigPtr &desired);
+
+    bool isEmpty() const;
+    /**
+     * The changes by output id, only for changed outputs.
+     */
+    QHash<int, Changes> outputs() const;
+
+private:
+    QHash<int, Changes> m_outputs;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(ConfigDelta::Changes)
+
+QDebug operator<<(QDebug dbg, const ConfigDelta &delta);
+
+#endif
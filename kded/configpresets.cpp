@@ -0,0 +1,81 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "configpresets.h"
+#include "../common/fileformat.h"
+#include "../common/globals.h"
+#include "kscreen_daemon_debug.h"
+#include "outputidentitycache.h"
+
+#include <kscreen/output.h>
+
+#include <QFile>
+
+QString ConfigPresets::dirName()
+{
+    return QStringLiteral("configs/");
+}
+
+ConfigPresets::ConfigPresets()
+{
+    index();
+}
+
+void ConfigPresets::index()
+{
+    m_presets.clear();
+    m_presetsSerial = Globals::presetsSerial();
+    const QStringList filePaths = Globals::presetFiles(dirName());
+    for (const QString &filePath : filePaths) {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        const QVector<OutputRecord> records = OutputRecord::listFromJson(FileFormat::decode(file.readAll()).array());
+        QStringList outputIds;
+        for (const OutputRecord &record : records) {
+            outputIds << record.id;
+        }
+        if (outputIds.isEmpty() || outputIds.contains(QString())) {
+            qCWarning(KSCREEN_KDED) << "Ignoring invalid layout preset" << filePath;
+            continue;
+        }
+        const QString key = topologyKey(outputIds);
+        if (m_presets.contains(key)) {
+            qCWarning(KSCREEN_KDED) << "Ignoring layout preset" << filePath << "for the same outputs as another one";
+            continue;
+        }
+        m_presets.insert(key, records);
+    }
+    qCDebug(KSCREEN_KDED) << "Indexed" << m_presets.size() << "layout presets";
+}
+
+QString ConfigPresets::topologyKey(QStringList outputIds)
+{
+    outputIds.sort();
+    return outputIds.join(QLatin1Char('\n'));
+}
+
+std::optional<QVector<OutputRecord>> ConfigPresets::outputs(const KScreen::OutputList &outputs)
+{
+    if (m_presetsSerial != Globals::presetsSerial()) {
+        qCDebug(KSCREEN_KDED) << "Layout presets changed";
+        index();
+    }
+    if (m_presets.isEmpty()) {
+        return std::nullopt;
+    }
+    QStringList outputIds;
+    for (const KScreen::OutputPtr &output : outputs) {
+        if (output->isConnected()) {
+            outputIds << OutputIdentityCache::self()->hash(output);
+        }
+    }
+    const auto it = m_presets.constFind(topologyKey(outputIds));
+    if (it == m_presets.constEnd()) {
+        return std::nullopt;
+    }
+    return *it;
+}
@@ -0,0 +1,50 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_CONFIGPRESETS_H
+#define KDED_CONFIGPRESETS_H
+
+#include "../common/singleton.h"
+#include "output.h"
+
+#include <kscreen/types.h>
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include <optional>
+
+/**
+ * Layouts provisioned by the administrator in kscreen/configs/ of the system data dirs.
+ *
+ * Preset files have the format of the stored configs, their file names do not matter. Each one
+ * is the layout for the combination of outputs whose ids (KScreen::Output::hash(), based on the
+ * EDID) it lists. They are indexed when the daemon starts, and again once presets were changed,
+ * and apply whenever the user has no stored config of their own for the connected outputs.
+ */
+class ConfigPresets : public Singleton<ConfigPresets>
+{
+public:
+    static QString dirName();
+
+    /**
+     * The preset layout for exactly the connected ones of @p outputs, if any.
+     */
+    std::optional<QVector<OutputRecord>> outputs(const KScreen::OutputList &outputs);
+
+private:
+    friend class Singleton<ConfigPresets>;
+    ConfigPresets();
+
+    void index();
+    static QString topologyKey(QStringList outputIds);
+
+    QHash<QString, QVector<OutputRecord>> m_presets;
+    // Of Globals::presetsSerial() when indexed.
+    quint64 m_presetsSerial = 0;
+};
+
+#endif
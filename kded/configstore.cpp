@@ -0,0 +1,339 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "configstore.h"
+#include "../common/globals.h"
+#include "kscreen_daemon_debug.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStringBuilder>
+#include <QtEndian>
+
+// Layout of the store file:
+//   8 bytes magic, followed by records of
+//   quint32 key size | quint32 data size | key (UTF-8) | data
+// A data size of s_tombstone marks a removed key. All integers are little endian.
+static const QByteArray s_magic = QByteArrayLiteral("KSCRDB\x00\x01");
+static const quint32 s_tombstone = 0xffffffff;
+static const qint64 s_recordHeaderSize = 2 * sizeof(quint32);
+// Don't bother compacting before this much garbage has accumulated.
+static const qint64 s_minCompactBytes = 64 * 1024;
+
+ConfigStore *ConfigStore::s_instance = nullptr;
+
+bool ConfigStore::isEnabled()
+{
+    static const bool enabled = qgetenv("KSCREEN_CONFIG_STORE") == QByteArrayLiteral("indexed");
+    return enabled;
+}
+
+ConfigStore *ConfigStore::self()
+{
+    if (!isEnabled()) {
+        return nullptr;
+    }
+    if (!s_instance) {
+        s_instance = new ConfigStore();
+    }
+    return s_instance;
+}
+
+void ConfigStore::destroy()
+{
+    delete s_instance;
+    s_instance = nullptr;
+}
+
+void ConfigStore::exportDisabledStore()
+{
+    const QString dirPath = Globals::dirPath();
+    if (isEnabled() || !QFile::exists(dirPath % fileName())) {
+        return;
+    }
+    QSet<QString> keys;
+    {
+        ConfigStore store;
+        if (!store.m_map) {
+            // Better keep it around than losing the layouts in it.
+            return;
+        }
+        const QStringList storeKeys = store.keys();
+        keys = QSet<QString>(storeKeys.constBegin(), storeKeys.constEnd());
+        const int count = store.exportDirectory(dirPath);
+        if (count != keys.size()) {
+            qCWarning(KSCREEN_KDED) << "Failed to export" << keys.size() - count << "records of the disabled config store" << store.filePath();
+            return;
+        }
+        qCDebug(KSCREEN_KDED) << "Exported" << count << "configs from the disabled config store" << store.filePath();
+    }
+
+    const auto fileInfos = QDir(dirPath).entryInfoList(QDir::Files);
+    for (const QFileInfo &fileInfo : fileInfos) {
+        if (fileInfo.fileName() != fileName() && !keys.contains(fileInfo.fileName())) {
+            QFile::remove(fileInfo.absoluteFilePath());
+        }
+    }
+    QFile::remove(dirPath % fileName());
+}
+
+ConfigStore::ConfigStore()
+{
+    QDir().mkpath(Globals::dirPath());
+    m_file.setFileName(filePath());
+    const bool existed = m_file.exists();
+    if (!load()) {
+        qCWarning(KSCREEN_KDED) << "Failed to load config store" << m_file.fileName() << m_file.errorString();
+        return;
+    }
+    if (!existed) {
+        const int count = importDirectory(Globals::dirPath());
+        qCDebug(KSCREEN_KDED) << "Imported" << count << "configs into" << m_file.fileName();
+    }
+}
+
+ConfigStore::~ConfigStore()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+}
+
+QString ConfigStore::fileName()
+{
+    return QStringLiteral("configs.db");
+}
+
+QString ConfigStore::filePath() const
+{
+    return Globals::dirPath() % fileName();
+}
+
+bool ConfigStore::load()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+    m_index.clear();
+    m_deadBytes = 0;
+
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    if (m_file.size() < s_magic.size()) {
+        // New or truncated store, start from scratch.
+        m_file.resize(0);
+        m_file.write(s_magic);
+        m_file.flush();
+    }
+    if (!remap()) {
+        return false;
+    }
+    if (QByteArray::fromRawData(reinterpret_cast<const char *>(m_map), s_magic.size()) != s_magic) {
+        qCWarning(KSCREEN_KDED) << "Config store has an unknown format, ignoring" << m_file.fileName();
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_file.close();
+        return false;
+    }
+
+    qint64 pos = s_magic.size();
+    while (pos + s_recordHeaderSize <= m_mapSize) {
+        const quint32 keySize = qFromLittleEndian<quint32>(m_map + pos);
+        const quint32 dataSize = qFromLittleEndian<quint32>(m_map + pos + sizeof(quint32));
+        const bool tombstone = dataSize == s_tombstone;
+        const qint64 recordSize = s_recordHeaderSize + keySize + (tombstone ? 0 : dataSize);
+        if (pos + recordSize > m_mapSize) {
+            break;
+        }
+        const QString key = QString::fromUtf8(reinterpret_cast<const char *>(m_map + pos + s_recordHeaderSize), keySize);
+
+        const auto it = m_index.constFind(key);
+        if (it != m_index.constEnd()) {
+            m_deadBytes += s_recordHeaderSize + keySize + it->size;
+        }
+        if (tombstone) {
+            m_index.remove(key);
+            m_deadBytes += recordSize;
+        } else {
+            m_index.insert(key, Entry{pos + s_recordHeaderSize + keySize, dataSize});
+        }
+        pos += recordSize;
+    }
+
+    if (pos != m_mapSize) {
+        // A write was interrupted, drop the incomplete record.
+        qCWarning(KSCREEN_KDED) << "Dropping incomplete record at the end of" << m_file.fileName();
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_file.resize(pos);
+        return remap();
+    }
+    return true;
+}
+
+bool ConfigStore::remap()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_mapSize = m_file.size();
+    m_map = m_file.map(0, m_mapSize);
+    return m_map != nullptr;
+}
+
+bool ConfigStore::contains(const QString &key) const
+{
+    return m_index.contains(key);
+}
+
+QByteArray ConfigStore::value(const QString &key) const
+{
+    const auto it = m_index.constFind(key);
+    if (it == m_index.constEnd() || !m_map) {
+        return QByteArray();
+    }
+    // Deep copy, the mapping is replaced on the next write.
+    return QByteArray(reinterpret_cast<const char *>(m_map + it->offset), it->size);
+}
+
+QStringList ConfigStore::keys() const
+{
+    return m_index.keys();
+}
+
+bool ConfigStore::insert(const QString &key, const QByteArray &data)
+{
+    const auto it = m_index.constFind(key);
+    if (it != m_index.constEnd() && m_map && it->size == quint32(data.size())
+        && QByteArray::fromRawData(reinterpret_cast<const char *>(m_map + it->offset), it->size) == data) {
+        qCDebug(KSCREEN_KDED) << "Stored config" << key << "is unchanged, skipping write";
+        return true;
+    }
+    return append(key, &data);
+}
+
+bool ConfigStore::remove(const QString &key)
+{
+    if (!m_index.contains(key)) {
+        return true;
+    }
+    return append(key, nullptr);
+}
+
+bool ConfigStore::append(const QString &key, const QByteArray *data)
+{
+    if (!m_map) {
+        return false;
+    }
+    const QByteArray keyData = key.toUtf8();
+    const quint32 dataSize = data ? data->size() : s_tombstone;
+
+    QByteArray record(s_recordHeaderSize, Qt::Uninitialized);
+    qToLittleEndian<quint32>(keyData.size(), record.data());
+    qToLittleEndian<quint32>(dataSize, record.data() + sizeof(quint32));
+    record.append(keyData);
+    if (data) {
+        record.append(*data);
+    }
+
+    const qint64 pos = m_file.size();
+    if (!m_file.seek(pos) || m_file.write(record) != record.size() || !m_file.flush()) {
+        qCWarning(KSCREEN_KDED) << "Failed to write to config store" << m_file.errorString();
+        m_file.resize(pos);
+        return false;
+    }
+
+    const auto it = m_index.constFind(key);
+    if (it != m_index.constEnd()) {
+        m_deadBytes += s_recordHeaderSize + keyData.size() + it->size;
+    }
+    if (data) {
+        m_index.insert(key, Entry{pos + s_recordHeaderSize + keyData.size(), dataSize});
+    } else {
+        m_index.remove(key);
+        m_deadBytes += record.size();
+    }
+
+    if (!remap()) {
+        return false;
+    }
+    if (m_deadBytes > s_minCompactBytes && m_deadBytes > m_mapSize / 2) {
+        return compact();
+    }
+    return true;
+}
+
+bool ConfigStore::compact()
+{
+    if (!m_map) {
+        return false;
+    }
+    QSaveFile file(m_file.fileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KSCREEN_KDED) << "Failed to compact config store" << file.errorString();
+        return false;
+    }
+    file.write(s_magic);
+    for (auto it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+        const QByteArray keyData = it.key().toUtf8();
+        QByteArray header(s_recordHeaderSize, Qt::Uninitialized);
+        qToLittleEndian<quint32>(keyData.size(), header.data());
+        qToLittleEndian<quint32>(it->size, header.data() + sizeof(quint32));
+        file.write(header);
+        file.write(keyData);
+        file.write(reinterpret_cast<const char *>(m_map + it->offset), it->size);
+    }
+    if (!file.commit()) {
+        qCWarning(KSCREEN_KDED) << "Failed to compact config store" << file.errorString();
+        return false;
+    }
+    qCDebug(KSCREEN_KDED) << "Compacted config store, dropped" << m_deadBytes << "bytes";
+    return load();
+}
+
+int ConfigStore::importDirectory(const QString &dirPath)
+{
+    int count = 0;
+    const QDir dir(dirPath);
+    const auto fileInfos = dir.entryInfoList(QDir::Files);
+    for (const QFileInfo &fileInfo : fileInfos) {
+        if (fileInfo.fileName() == fileName()) {
+            continue;
+        }
+        QFile file(fileInfo.absoluteFilePath());
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        if (insert(fileInfo.fileName(), file.readAll())) {
+            count++;
+        }
+    }
+    return count;
+}
+
+int ConfigStore::exportDirectory(const QString &dirPath) const
+{
+    if (!QDir().mkpath(dirPath)) {
+        return 0;
+    }
+    int count = 0;
+    for (auto it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+        QSaveFile file(QDir(dirPath).filePath(it.key()));
+        if (!file.open(QIODevice::WriteOnly)) {
+            continue;
+        }
+        file.write(reinterpret_cast<const char *>(m_map + it->offset), it->size);
+        if (file.commit()) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,89 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_CONFIGSTORE_H
+#define KDED_CONFIGSTORE_H
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Indexed single-file store for the daemon's stored layouts.
+ *
+ * Instead of one JSON file per connectedOutputsHash() in Config::configsDirPath() every layout
+ * (including the "_lidOpened" and "fixed-config" variants) is kept as one record in a single
+ * append-only file. The file is memory-mapped and indexed on load, so existence checks and
+ * lookups are hash lookups in memory. Superseded and removed records are dropped by compaction.
+ *
+ * The store is optional. It is enabled by setting KSCREEN_CONFIG_STORE=indexed in the environment
+ * of kded. On first use the existing per-hash files are imported. Once the store is disabled again
+ * its records are exported back to per-hash files, see exportDisabledStore().
+ */
+class ConfigStore
+{
+public:
+    static bool isEnabled();
+    static ConfigStore *self();
+    static void destroy();
+    /**
+     * Turns the records of a store that was used before, but is not enabled anymore, back into
+     * per-hash files in Globals::dirPath() and removes the store file. Per-hash files the store
+     * does not know about are left over from its import and are removed as well.
+     *
+     * Does nothing if the store is enabled or there is no store file.
+     */
+    static void exportDisabledStore();
+
+    /**
+     * The name of the store file in Globals::dirPath(), which is not a stored layout.
+     */
+    static QString fileName();
+    QString filePath() const;
+
+    bool contains(const QString &key) const;
+    QByteArray value(const QString &key) const;
+    QStringList keys() const;
+
+    bool insert(const QString &key, const QByteArray &data);
+    bool remove(const QString &key);
+
+    /**
+     * Imports all files in @p dirPath as records, keyed by their file name.
+     * @returns the number of imported records
+     */
+    int importDirectory(const QString &dirPath);
+    /**
+     * Writes every record as a standalone file named after its key into @p dirPath.
+     * @returns the number of exported records
+     */
+    int exportDirectory(const QString &dirPath) const;
+
+    bool compact();
+
+private:
+    ConfigStore();
+    ~ConfigStore();
+
+    struct Entry {
+        qint64 offset = 0;
+        quint32 size = 0;
+    };
+
+    bool load();
+    bool remap();
+    bool append(const QString &key, const QByteArray *data);
+
+    QFile m_file;
+    uchar *m_map = nullptr;
+    qint64 m_mapSize = 0;
+    QHash<QString, Entry> m_index;
+    qint64 m_deadBytes = 0;
+
+    static ConfigStore *s_instance;
+};
+
+#endif
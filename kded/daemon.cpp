@@ -9,19 +9,34 @@
 */
 #include "daemon.h"
 
+#include "../common/flightrecorder.h"
 #include "../common/orientation_sensor.h"
+#include "../common/persistence.h"
+#include "adaptivedebouncer.h"
+#include "applymetrics.h"
+#include "applyscheduler.h"
+#include "clientconfigurations.h"
 #include "config.h"
+#include "configcache.h"
+#include "configcompactor.h"
+#include "configdelta.h"
+#include "configpresets.h"
+#include "configstore.h"
 #include "device.h"
+#include "flapguard.h"
 #include "generator.h"
 #include "kscreen_daemon_debug.h"
 #include "kscreenadaptor.h"
 #include "osdmanager.h"
+#include "outputdatacache.h"
+#include "outputidentitycache.h"
+#include "storedtopologies.h"
+#include "topologycache.h"
 
 #include <kscreen/configmonitor.h>
 #include <kscreen/getconfigoperation.h>
 #include <kscreen/log.h>
 #include <kscreen/output.h>
-#include <kscreen/setconfigoperation.h>
 
 #include <KActionCollection>
 #include <KGlobalAccel>
@@ -34,6 +49,8 @@
 #include <QShortcut>
 #include <QTimer>
 
+#include <algorithm>
+
 #if HAVE_X11
 #include <QX11Info>
 #include <X11/Xatom.h>
@@ -67,15 +84,27 @@ struct XDeleter {
 KScreenDaemon::KScreenDaemon(QObject *parent, const QList<QVariant> &)
     : KDEDModule(parent)
     , m_monitoring(false)
-    , m_changeCompressor(new QTimer(this))
+    , m_changeDebouncer(new AdaptiveDebouncer(std::chrono::milliseconds(10), std::chrono::milliseconds(1000), this))
     , m_saveTimer(nullptr)
     , m_lidClosedTimer(new QTimer(this))
-    , m_orientationSensor(new OrientationSensor(this))
+    , m_applyScheduler(new ApplyScheduler(this))
+    , m_flapGuard(new FlapGuard(this))
+    , m_topologyCache(new TopologyCache(this))
+    , m_metrics(new ApplyMetrics)
+    , m_clientConfigurations(new ClientConfigurations)
 {
-    connect(m_orientationSensor, &OrientationSensor::availableChanged, this, &KScreenDaemon::updateOrientation);
-    connect(m_orientationSensor, &OrientationSensor::valueChanged, this, &KScreenDaemon::updateOrientation);
+    connect(m_applyScheduler, &ApplyScheduler::idle, this, &KScreenDaemon::applyFinished);
+    connect(m_flapGuard, &FlapGuard::settled, this, &KScreenDaemon::outputSettled);
 
     KScreen::Log::instance();
+    // Keep file writes off the main thread, which is shared with all other kded modules.
+    Persistence::self()->startWorker();
+    // Before anything reads the per-hash files, they are only up to date after this.
+    ConfigStore::exportDisabledStore();
+    // Get going with what does not need the backend, while the backend is being queried: probing
+    // the device and reading the configs that are likely to be applied.
+    Device::self();
+    ConfigCache::self()->prefetch(ConfigCompactor::self()->recentlyUsed(2));
     QMetaObject::invokeMethod(this, "getInitialConfig", Qt::QueuedConnection);
 }
 
@@ -100,11 +129,23 @@ KScreenDaemon::~KScreenDaemon()
 {
     Generator::destroy();
     Device::destroy();
+    ConfigCompactor::destroy();
+    ConfigPresets::destroy();
+    ConfigCache::destroy();
+    OutputDataCache::destroy();
+    OutputIdentityCache::destroy();
+    StoredTopologies::destroy();
+    ConfigStore::destroy();
+    // Flushes pending writes.
+    Persistence::destroy();
 }
 
 void KScreenDaemon::init()
 {
     KActionCollection *coll = new KActionCollection(this);
+
+    // Index the layout presets before the first config is applied.
+    ConfigPresets::self();
     QAction *action = coll->addAction(QStringLiteral("display"));
     action->setText(i18n("Switch Display"));
     QList<QKeySequence> switchDisplayShortcuts({Qt::Key_Display, Qt::MetaModifier + Qt::Key_P});
@@ -112,12 +153,11 @@ void KScreenDaemon::init()
     connect(action, &QAction::triggered, this, &KScreenDaemon::displayButton);
 
     new KScreenAdaptor(this);
-    // Initialize OSD manager to register its dbus interface
+    // Registers the OSD's D-Bus service right away for other clients, its QML is only loaded once
+    // an OSD is shown.
     m_osdManager = new KScreen::OsdManager(this);
 
-    m_changeCompressor->setInterval(10);
-    m_changeCompressor->setSingleShot(true);
-    connect(m_changeCompressor, &QTimer::timeout, this, &KScreenDaemon::applyConfig);
+    connect(m_changeDebouncer, &AdaptiveDebouncer::triggered, this, &KScreenDaemon::applyConfig);
 
     m_lidClosedTimer->setInterval(1000);
     m_lidClosedTimer->setSingleShot(true);
@@ -138,18 +178,50 @@ void KScreenDaemon::init()
         m_lidClosedTimer->stop();
     });
 
-    connect(Generator::self(), &Generator::ready, this, [this] {
-        applyConfig();
+    Generator::self()->setCurrentConfig(m_monitoredConfig->data());
+    monitorConnectedChange();
 
-        if (Device::self()->isLaptop() && Device::self()->isLidClosed()) {
-            disableLidOutput();
+    if (Device::self()->isReady()) {
+        deviceReady();
+    } else {
+        connect(Generator::self(), &Generator::ready, this, &KScreenDaemon::deviceReady);
+        // A known layout without the lid in play is applied right away, UPower may take a while.
+        if (m_monitoredConfig->fileExists() && !m_monitoredConfig->dependsOnLid()) {
+            qCDebug(KSCREEN_KDED) << "Applying known config before the device state is known";
+            applyKnownConfig();
+            m_appliedBeforeDeviceReady = true;
         }
+    }
 
-        m_startingUp = false;
+    // Stored configs are compacted in the background, well after startup and then daily.
+    auto *compactTimer = new QTimer(this);
+    compactTimer->setInterval(std::chrono::hours(24));
+    connect(compactTimer, &QTimer::timeout, this, &KScreenDaemon::compactConfigs);
+    QTimer::singleShot(std::chrono::minutes(5), this, [this, compactTimer]() {
+        compactConfigs();
+        compactTimer->start();
     });
+}
 
-    Generator::self()->setCurrentConfig(m_monitoredConfig->data());
-    monitorConnectedChange();
+void KScreenDaemon::deviceReady()
+{
+    if (!m_appliedBeforeDeviceReady) {
+        applyConfig();
+    }
+
+    if (Device::self()->isLaptop() && Device::self()->isLidClosed()) {
+        disableLidOutput();
+    }
+
+    m_startingUp = false;
+}
+
+void KScreenDaemon::compactConfigs()
+{
+    if (!m_monitoredConfig) {
+        return;
+    }
+    ConfigCompactor::self()->compact(m_monitoredConfig->id());
 }
 
 void KScreenDaemon::updateOrientation()
@@ -162,7 +234,7 @@ void KScreenDaemon::updateOrientation()
         return;
     }
 
-    if (!m_orientationSensor->available() || !m_orientationSensor->enabled()) {
+    if (!m_orientationSensor || !m_orientationSensor->available() || !m_orientationSensor->enabled()) {
         return;
     }
 
@@ -178,11 +250,34 @@ void KScreenDaemon::updateOrientation()
     }
 
     m_monitoredConfig->setDeviceOrientation(orientation);
-    if (m_monitoring) {
-        doApplyConfig(m_monitoredConfig->data());
-    } else {
-        m_configDirty = true;
+    // Coalesced with an apply that may still be in flight.
+    refreshConfig();
+}
+
+void KScreenDaemon::setOrientationSensorEnabled(bool enabled)
+{
+    if (!m_orientationSensor) {
+        if (!enabled || !m_monitoredConfig) {
+            return;
+        }
+        // Connecting to the sensor backend is not free, most devices have nothing to rotate.
+        // Auto rotation is on by default, so this checks whether it could happen at all.
+        const KScreen::ConfigPtr config = m_monitoredConfig->data();
+        const auto features = config->supportedFeatures();
+        if (!features.testFlag(KScreen::Config::Feature::AutoRotation) || !features.testFlag(KScreen::Config::Feature::TabletMode)) {
+            return;
+        }
+        const KScreen::OutputList outputs = config->outputs();
+        if (std::none_of(outputs.cbegin(), outputs.cend(), [](const KScreen::OutputPtr &output) {
+                return output->isConnected() && output->type() == KScreen::Output::Panel;
+            })) {
+            return;
+        }
+        m_orientationSensor = new OrientationSensor(this);
+        connect(m_orientationSensor, &OrientationSensor::availableChanged, this, &KScreenDaemon::updateOrientation);
+        connect(m_orientationSensor, &OrientationSensor::valueChanged, this, &KScreenDaemon::updateOrientation);
     }
+    m_orientationSensor->setEnabled(enabled);
 }
 
 void KScreenDaemon::doApplyConfig(const KScreen::ConfigPtr &config)
@@ -196,51 +291,117 @@ void KScreenDaemon::doApplyConfig(const KScreen::ConfigPtr &config)
 
 void KScreenDaemon::doApplyConfig(std::unique_ptr<Config> config)
 {
+    // Kept up to date with the backend by the config monitor.
+    const KScreen::ConfigPtr liveConfig = m_monitoredConfig ? m_monitoredConfig->data() : KScreen::ConfigPtr();
     m_monitoredConfig = std::move(config);
+    ConfigCompactor::self()->markUsed(m_monitoredConfig->id());
+    m_clientConfigurations->switchedTo(m_monitoredConfig->data());
 
     m_monitoredConfig->activateControlWatching();
-    m_orientationSensor->setEnabled(m_monitoredConfig->autoRotationRequested());
+    setOrientationSensorEnabled(m_monitoredConfig->autoRotationRequested());
 
     connect(m_monitoredConfig.get(), &Config::controlChanged, this, [this]() {
-        m_orientationSensor->setEnabled(m_monitoredConfig->autoRotationRequested());
+        m_topologyCache->clear();
+        setOrientationSensorEnabled(m_monitoredConfig->autoRotationRequested());
         updateOrientation();
     });
 
-    refreshConfig();
+    refreshConfig(liveConfig);
 }
 
-void KScreenDaemon::refreshConfig()
+void KScreenDaemon::refreshConfig(const KScreen::ConfigPtr &liveConfig)
 {
+    m_metrics->end(ApplyMetrics::Stage::Resolve);
     setMonitorForChanges(false);
-    m_configDirty = false;
     KScreen::ConfigMonitor::instance()->addConfig(m_monitoredConfig->data());
 
-    connect(new KScreen::SetConfigOperation(m_monitoredConfig->data()), &KScreen::SetConfigOperation::finished, this, [this]() {
-        qCDebug(KSCREEN_KDED) << "Config applied";
-        if (m_configDirty) {
-            // Config changed in the meantime again, apply.
-            doApplyConfig(m_monitoredConfig->data());
-        } else {
-            setMonitorForChanges(true);
+    // The device may change while the config is being applied, it is cached for this state.
+    m_scheduledConfig = m_monitoredConfig->data();
+    m_scheduledTopologyKey = topologyKey();
+
+    // With an apply in flight the live config is about to change, no telling what is a no-op.
+    if (liveConfig && liveConfig != m_monitoredConfig->data() && !m_applyScheduler->isBusy()) {
+        const ConfigDelta delta = ConfigDelta::compute(liveConfig, m_monitoredConfig->data());
+        if (delta.isEmpty()) {
+            qCDebug(KSCREEN_KDED) << "Config matches the backend already, not applying it";
+            m_metrics->count(ApplyMetrics::Counter::SkippedApplies);
+            // Like a real apply, finished once the caller is done. Unless a real apply was started
+            // in the meantime, which finishes on its own.
+            QMetaObject::invokeMethod(
+                this,
+                [this, config = m_monitoredConfig->data()]() {
+                    if (!m_applyScheduler->isBusy()) {
+                        applyFinished(config, true);
+                    }
+                },
+                Qt::QueuedConnection);
+            return;
         }
-    });
+        qCDebug(KSCREEN_KDED) << "Applying changes" << delta;
+    }
+    m_metrics->count(ApplyMetrics::Counter::Applies);
+    m_metrics->begin(ApplyMetrics::Stage::Apply);
+    m_applyScheduler->schedule(m_monitoredConfig->data());
+}
+
+void KScreenDaemon::applyFinished(const KScreen::ConfigPtr &config, bool success)
+{
+    FlightRecorder::instant("daemon", "applyFinished");
+    m_metrics->end(ApplyMetrics::Stage::Apply);
+    m_metrics->end(ApplyMetrics::Stage::Total);
+    if (success && config == m_scheduledConfig && m_scheduledTopologyKey) {
+        m_topologyCache->insert(*m_scheduledTopologyKey, config);
+    }
+    setMonitorForChanges(true);
+    if (m_clientConfigurations->applyFinished(config, m_monitoredConfig->data(), success)) {
+        saveCurrentConfig();
+    }
 }
 
 void KScreenDaemon::applyConfig()
 {
+    KSCREEN_TRACE_SPAN("daemon", "applyConfig");
     qCDebug(KSCREEN_KDED) << "Applying config";
+    m_metrics->end(ApplyMetrics::Stage::Debounce);
+    // Ends once the config is handed to the scheduler.
+    m_metrics->begin(ApplyMetrics::Stage::Resolve);
+    if (const auto key = topologyKey()) {
+        if (auto cachedConfig = m_topologyCache->find(*key, m_monitoredConfig->data())) {
+            qCDebug(KSCREEN_KDED) << "Applying config cached for this topology";
+            doApplyConfig(cachedConfig);
+            return;
+        }
+    }
     if (m_monitoredConfig->fileExists()) {
         applyKnownConfig();
         return;
     }
+    if (auto presetConfig = m_monitoredConfig->readPresetFile()) {
+        qCDebug(KSCREEN_KDED) << "Applying layout preset";
+        doApplyConfig(std::move(presetConfig));
+        return;
+    }
+    if (auto nearestConfig = m_monitoredConfig->readNearestFile()) {
+        qCDebug(KSCREEN_KDED) << "Applying config derived from a similar known config";
+        doApplyConfig(std::move(nearestConfig));
+        return;
+    }
     applyIdealConfig();
 }
 
+std::optional<TopologyCache::Key> KScreenDaemon::topologyKey() const
+{
+    const auto orientation = m_orientationSensor && m_orientationSensor->enabled() ? m_orientationSensor->value() : QOrientationReading::Undefined;
+    return TopologyCache::key(m_monitoredConfig->data(), orientation);
+}
+
 void KScreenDaemon::applyKnownConfig()
 {
     qCDebug(KSCREEN_KDED) << "Applying known config";
 
+    m_metrics->begin(ApplyMetrics::Stage::Parse);
     std::unique_ptr<Config> readInConfig = m_monitoredConfig->readFile();
+    m_metrics->end(ApplyMetrics::Stage::Parse);
     if (readInConfig) {
         doApplyConfig(std::move(readInConfig));
     } else {
@@ -251,6 +412,7 @@ void KScreenDaemon::applyKnownConfig()
 
 void KScreenDaemon::applyLayoutPreset(const QString &presetName)
 {
+    KSCREEN_TRACE_SPAN("dbus", "applyLayoutPreset");
     const QMetaEnum actionEnum = QMetaEnum::fromType<KScreen::OsdAction::Action>();
     Q_ASSERT(actionEnum.isValid());
 
@@ -270,15 +432,58 @@ bool KScreenDaemon::getAutoRotate()
 
 void KScreenDaemon::setAutoRotate(bool value)
 {
+    KSCREEN_TRACE_SPAN("dbus", "setAutoRotate");
     if (!m_monitoredConfig) {
         return;
     }
     m_monitoredConfig->setAutoRotate(value);
-    m_orientationSensor->setEnabled(value);
+    setOrientationSensorEnabled(m_monitoredConfig->autoRotationRequested());
+}
+
+quint32 KScreenDaemon::configurationGeneration() const
+{
+    return m_clientConfigurations->generation();
+}
+
+QVariantMap KScreenDaemon::outputFlapCounts() const
+{
+    return m_flapGuard->flapCounts();
+}
+
+QVariantMap KScreenDaemon::applyMetrics() const
+{
+    return m_metrics->toVariantMap();
+}
+
+QString KScreenDaemon::flightRecording() const
+{
+    return QString::fromUtf8(FlightRecorder::toTraceJson());
+}
+
+quint32 KScreenDaemon::applyConfiguration(const QString &layout, const QString &control, quint32 generation)
+{
+    KSCREEN_TRACE_SPAN("dbus", "applyConfiguration");
+    if (!m_monitoredConfig) {
+        return 0;
+    }
+    const KScreen::ConfigPtr config = m_clientConfigurations->take(layout, control, generation, m_monitoredConfig->data());
+    if (!config) {
+        return 0;
+    }
+
+    qCDebug(KSCREEN_KDED) << "Applying configuration from client";
+    if (calledFromDBus()) {
+        // Answered once applied, the client reads back the config in effect then.
+        setDelayedReply(true);
+        m_clientConfigurations->delayReply(message().createReply());
+    }
+    doApplyConfig(config);
+    return m_clientConfigurations->generation();
 }
 
 void KScreenDaemon::applyOsdAction(KScreen::OsdAction::Action action)
 {
+    KSCREEN_TRACE_SPAN("daemon", "applyOsdAction");
     switch (action) {
     case KScreen::OsdAction::NoAction:
         qCDebug(KSCREEN_KDED) << "OSD: no action";
@@ -311,7 +516,10 @@ void KScreenDaemon::applyIdealConfig()
 {
     const bool showOsd = m_monitoredConfig->data()->connectedOutputs().count() > 1 && !m_startingUp;
 
-    doApplyConfig(Generator::self()->idealConfig(m_monitoredConfig->data()));
+    m_metrics->begin(ApplyMetrics::Stage::Generate);
+    KScreen::ConfigPtr idealConfig = Generator::self()->idealConfig(m_monitoredConfig->data());
+    m_metrics->end(ApplyMetrics::Stage::Generate);
+    doApplyConfig(idealConfig);
 
     if (showOsd) {
         qCDebug(KSCREEN_KDED) << "Getting ideal config from user via OSD...";
@@ -324,6 +532,7 @@ void KScreenDaemon::applyIdealConfig()
 
 void KScreenDaemon::configChanged()
 {
+    FlightRecorder::instant("daemon", "configChanged");
     qCDebug(KSCREEN_KDED) << "Change detected";
     m_monitoredConfig->log();
 
@@ -517,14 +726,20 @@ void KScreenDaemon::alignX11TouchScreen()
 
 void KScreenDaemon::saveCurrentConfig()
 {
+    KSCREEN_TRACE_SPAN("daemon", "saveCurrentConfig");
     qCDebug(KSCREEN_KDED) << "Saving current config to file";
 
     // We assume the config is valid, since it's what we got, but we are interested
     // in the "at least one enabled screen" check
 
     if (m_monitoredConfig->canBeApplied()) {
+        m_metrics->count(ApplyMetrics::Counter::Saves);
         m_monitoredConfig->writeFile();
+        if (const auto key = topologyKey()) {
+            m_topologyCache->insert(*key, m_monitoredConfig->data());
+        }
         m_monitoredConfig->log();
+        qCDebug(KSCREEN_KDED) << "Writes performed:" << Persistence::self()->writesPerformed() << "skipped:" << Persistence::self()->writesSkipped();
     } else {
         qCWarning(KSCREEN_KDED) << "Config does not have at least one screen enabled, WILL NOT save this config, this is not what user wants.";
         m_monitoredConfig->log();
@@ -541,6 +756,7 @@ void KScreenDaemon::displayButton()
 
 void KScreenDaemon::lidClosedChanged(bool lidIsClosed)
 {
+    FlightRecorder::instant("daemon", lidIsClosed ? "lidClosed" : "lidOpened");
     // Ignore this when we don't have any external monitors, we can't turn off our
     // only screen
     if (m_monitoredConfig->data()->connectedOutputs().count() == 1) {
@@ -567,6 +783,7 @@ void KScreenDaemon::lidClosedChanged(bool lidIsClosed)
 
 void KScreenDaemon::disableLidOutput()
 {
+    KSCREEN_TRACE_SPAN("timer", "disableLidOutput");
     // Make sure nothing has changed in the past second... :-)
     if (!Device::self()->isLidClosed()) {
         return;
@@ -596,18 +813,37 @@ void KScreenDaemon::disableLidOutput()
 
 void KScreenDaemon::outputConnectedChanged()
 {
-    if (!m_changeCompressor->isActive()) {
-        m_changeCompressor->start();
-    }
-
+    FlightRecorder::instant("daemon", "outputConnectedChanged");
     KScreen::Output *output = qobject_cast<KScreen::Output *>(sender());
     qCDebug(KSCREEN_KDED) << "outputConnectedChanged():" << output->name();
+    m_metrics->begin(ApplyMetrics::Stage::Debounce, false);
+    m_metrics->begin(ApplyMetrics::Stage::Total, false);
+    if (m_flapGuard->toggled(output->name())) {
+        outputSettled(output->name());
+    }
+}
 
-    if (output->isConnected()) {
-        Q_EMIT outputConnected(output->name());
+void KScreenDaemon::outputSettled(const QString &outputName)
+{
+    // A pending layout for the previous outputs is stale, the new one follows shortly.
+    m_applyScheduler->cancel();
+    m_clientConfigurations->drop();
+
+    // Connectors tend to flicker while being plugged, wait until this one settles.
+    m_changeDebouncer->event(outputName);
+    if (!m_monitoredConfig) {
+        return;
+    }
+
+    const KScreen::OutputList outputs = m_monitoredConfig->data()->outputs();
+    const bool connected = std::any_of(outputs.cbegin(), outputs.cend(), [&outputName](const KScreen::OutputPtr &output) {
+        return output->name() == outputName && output->isConnected();
+    });
+    if (connected) {
+        Q_EMIT outputConnected(outputName);
 
         if (!m_monitoredConfig->fileExists()) {
-            Q_EMIT unknownOutputConnected(output->name());
+            Q_EMIT unknownOutputConnected(outputName);
         }
     }
 }
@@ -624,7 +860,11 @@ void KScreenDaemon::monitorConnectedChange()
         this,
         [this](const KScreen::OutputPtr &output) {
             if (output->isConnected()) {
-                m_changeCompressor->start();
+                m_metrics->begin(ApplyMetrics::Stage::Debounce, false);
+                m_metrics->begin(ApplyMetrics::Stage::Total, false);
+            }
+            if (output->isConnected() && m_flapGuard->toggled(output->name())) {
+                outputSettled(output->name());
             }
             connect(output.data(), &KScreen::Output::isConnectedChanged, this, &KScreenDaemon::outputConnectedChanged, Qt::UniqueConnection);
         },
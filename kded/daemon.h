@@ -10,16 +10,24 @@
 #include "../common/globals.h"
 #include "config-X11.h"
 #include "osdaction.h"
+#include "topologycache.h"
 
 #include <kscreen/config.h>
 
 #include <kdedmodule.h>
 
+#include <QDBusContext>
 #include <QVariant>
 
 #include <memory>
+#include <optional>
 
+class AdaptiveDebouncer;
+class ApplyMetrics;
+class ApplyScheduler;
+class ClientConfigurations;
 class Config;
+class FlapGuard;
 class OrientationSensor;
 
 namespace KScreen
@@ -29,7 +37,7 @@ class OsdManager;
 
 class QTimer;
 
-class KScreenDaemon : public KDEDModule
+class KScreenDaemon : public KDEDModule, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kde.KScreen")
@@ -43,6 +51,32 @@ public Q_SLOTS:
     void applyLayoutPreset(const QString &presetName);
     bool getAutoRotate();
     void setAutoRotate(bool value);
+    /**
+     * Changes every time the daemon switches to other outputs or takes a client's configuration.
+     */
+    quint32 configurationGeneration() const;
+    /**
+     * Applies and saves the serialized @p layout with its @p control data on behalf of a client,
+     * so that the daemon stays the only writer of the config files. Rejected if the config changed
+     * since the client read @p generation. Replied to once the configuration was applied.
+     *
+     * @return the new generation, or 0 if the configuration was rejected or not applied
+     */
+    quint32 applyConfiguration(const QString &layout, const QString &control, quint32 generation);
+    /**
+     * How often each output started flapping, toggling its connection in quick succession, since
+     * the daemon started.
+     */
+    QVariantMap outputFlapCounts() const;
+    /**
+     * Latency histograms of the stages from an output being plugged until its config is applied,
+     * and counters of applies, saves and writes.
+     */
+    QVariantMap applyMetrics() const;
+    /**
+     * What the daemon did recently, in the Chrome trace event format.
+     */
+    QString flightRecording() const;
 
 Q_SIGNALS:
     // DBus
@@ -50,6 +84,8 @@ Q_SIGNALS:
     void unknownOutputConnected(const QString &outputName);
 
 private:
+    friend class DaemonBenchmark;
+
     Q_INVOKABLE void getInitialConfig();
     void init();
 
@@ -67,26 +103,43 @@ private:
     void setMonitorForChanges(bool enabled);
 
     void outputConnectedChanged();
+    void outputSettled(const QString &outputName);
     void applyOsdAction(KScreen::OsdAction::Action action);
 
     void doApplyConfig(const KScreen::ConfigPtr &config);
     void doApplyConfig(std::unique_ptr<Config> config);
-    void refreshConfig();
+    /**
+     * Applies the monitored config, unless it does not differ from @p liveConfig.
+     */
+    void refreshConfig(const KScreen::ConfigPtr &liveConfig = KScreen::ConfigPtr());
+    void applyFinished(const KScreen::ConfigPtr &config, bool success);
+    std::optional<TopologyCache::Key> topologyKey() const;
 
     void monitorConnectedChange();
     void disableOutput(const KScreen::OutputPtr &output);
 
     void updateOrientation();
+    void setOrientationSensorEnabled(bool enabled);
+    void compactConfigs();
+    void deviceReady();
 
     std::unique_ptr<Config> m_monitoredConfig;
     bool m_monitoring;
-    bool m_configDirty = true;
-    QTimer *m_changeCompressor;
+    AdaptiveDebouncer *m_changeDebouncer;
     QTimer *m_saveTimer;
     QTimer *m_lidClosedTimer;
-    KScreen::OsdManager *m_osdManager;
-    OrientationSensor *m_orientationSensor;
+    ApplyScheduler *m_applyScheduler;
+    FlapGuard *m_flapGuard;
+    TopologyCache *m_topologyCache;
+    // The config handed to the scheduler last, and the state it was resolved for
+    KScreen::ConfigPtr m_scheduledConfig;
+    std::optional<TopologyCache::Key> m_scheduledTopologyKey;
+    std::unique_ptr<ApplyMetrics> m_metrics;
+    std::unique_ptr<ClientConfigurations> m_clientConfigurations;
+    KScreen::OsdManager *m_osdManager = nullptr;
+    OrientationSensor *m_orientationSensor = nullptr;
     bool m_startingUp = true;
+    bool m_appliedBeforeDeviceReady = false;
 };
 
 #endif /*KSCREEN_DAEMON_H*/
@@ -0,0 +1,82 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "flapguard.h"
+#include "../common/flightrecorder.h"
+#include "kscreen_daemon_debug.h"
+
+#include <QTimer>
+
+#include <algorithm>
+
+// This many changes within the flap period make an output flapping.
+static const int s_flapToggles = 4;
+static const qint64 s_flapPeriodMs = 5000;
+static const qint64 s_minBackoffMs = 1000;
+static const qint64 s_maxBackoffMs = 30000;
+// The backoff starts over once an output stayed stable this long.
+static const qint64 s_stablePeriodMs = 5 * 60 * 1000;
+
+FlapGuard::FlapGuard(QObject *parent)
+    : QObject(parent)
+    , m_stablePeriodMs(s_stablePeriodMs)
+{
+    m_clock.start();
+}
+
+bool FlapGuard::toggled(const QString &name)
+{
+    const qint64 now = m_clock.elapsed();
+    Output &output = m_outputs[name];
+
+    // The toggles are cleared once settled, the last one is kept apart for this.
+    if (output.lastToggle >= 0 && now - output.lastToggle > m_stablePeriodMs) {
+        output.level = 0;
+    }
+    output.lastToggle = now;
+    output.toggles.append(now);
+    while (now - output.toggles.first() > s_flapPeriodMs) {
+        output.toggles.removeFirst();
+    }
+
+    if (output.holdStart < 0) {
+        if (output.toggles.count() < s_flapToggles) {
+            return true;
+        }
+        output.holdStart = now;
+        output.level++;
+        output.flaps++;
+        qCWarning(KSCREEN_KDED) << "Output" << name << "is flapping," << output.flaps << "times so far, holding back its changes";
+    }
+
+    if (!output.timer) {
+        output.timer = new QTimer(this);
+        output.timer->setSingleShot(true);
+        connect(output.timer, &QTimer::timeout, this, [this, name]() {
+            Output &output = m_outputs[name];
+            output.holdStart = -1;
+            output.toggles.clear();
+            FlightRecorder::instant("timer", "flapBackoff");
+            qCDebug(KSCREEN_KDED) << "Output" << name << "settled";
+            Q_EMIT settled(name);
+        });
+    }
+    // Wait for a stable period, but never past the longest backoff, so that an output which never
+    // stops flapping is still picked up in its latest state.
+    const qint64 backoffMs = std::min(s_minBackoffMs << std::min(output.level - 1, 5), s_maxBackoffMs);
+    const qint64 deadlineMs = output.holdStart + s_maxBackoffMs - now;
+    output.timer->start(static_cast<int>(std::max<qint64>(0, std::min(backoffMs, deadlineMs))));
+    qCDebug(KSCREEN_KDED) << "Holding back change of" << name << "for" << output.timer->interval() << "ms";
+    return false;
+}
+
+QVariantMap FlapGuard::flapCounts() const
+{
+    QVariantMap counts;
+    for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
+        counts.insert(it.key(), it->flaps);
+    }
+    return counts;
+}
@@ -0,0 +1,66 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_FLAPGUARD_H
+#define KDED_FLAPGUARD_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QVariantMap>
+
+class QTimer;
+
+/**
+ * Holds back the connection changes of outputs whose link keeps dropping.
+ *
+ * An output that toggles its connection state several times in a short period is considered
+ * flapping. Its changes are then held back until it stayed stable for a backoff period, which
+ * doubles with every flapping episode up to a limit. The state of a held back output is always
+ * picked up eventually, at the latest when the longest backoff elapsed.
+ */
+class FlapGuard : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FlapGuard(QObject *parent = nullptr);
+
+    /**
+     * Records a connection change of the output @p name.
+     *
+     * @return true if the change should be handled now, false if it is held back until settled()
+     */
+    bool toggled(const QString &name);
+
+    /**
+     * The number of flapping episodes seen so far by output name, to find bad cables and hubs.
+     */
+    QVariantMap flapCounts() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when the output @p name stopped flapping, its latest state should be handled now.
+     */
+    void settled(const QString &name);
+
+private:
+    friend class TestFlapGuard;
+
+    struct Output {
+        QTimer *timer = nullptr;
+        // Within the flap period
+        QList<qint64> toggles;
+        qint64 lastToggle = -1;
+        qint64 holdStart = -1;
+        int level = 0;
+        quint32 flaps = 0;
+    };
+
+    QElapsedTimer m_clock;
+    qint64 m_stablePeriodMs;
+    QHash<QString, Output> m_outputs;
+};
+
+#endif
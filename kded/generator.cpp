@@ -6,6 +6,7 @@
 */
 
 #include "generator.h"
+#include "../common/flightrecorder.h"
 #include "device.h"
 #include "kscreen_daemon_debug.h"
 #include "output.h"
@@ -69,6 +70,7 @@ void Generator::setCurrentConfig(const KScreen::ConfigPtr &currentConfig)
 
 KScreen::ConfigPtr Generator::idealConfig(const KScreen::ConfigPtr &currentConfig)
 {
+    KSCREEN_TRACE_SPAN("generator", "idealConfig");
     Q_ASSERT(currentConfig);
 
     //     KDebug::Block idealBlock("Ideal Config");
@@ -138,6 +140,7 @@ KScreen::ConfigPtr Generator::fallbackIfNeeded(const KScreen::ConfigPtr &config)
 
 KScreen::ConfigPtr Generator::displaySwitch(DisplaySwitchAction action)
 {
+    KSCREEN_TRACE_SPAN("generator", "displaySwitch");
     //     KDebug::Block switchBlock("Display Switch");
     KScreen::ConfigPtr config = m_currentConfig;
     Q_ASSERT(config);
@@ -37,14 +37,22 @@ public:
     }
 };
 
-OsdManager::OsdManager(QObject *parent)
-    : QObject(parent)
-    , m_cleanupTimer(new QTimer(this))
+void OsdManager::registerQmlTypes()
 {
+    static bool registered = false;
+    if (registered) {
+        return;
+    }
+    registered = true;
     qmlRegisterSingletonType<KScreen::OsdAction>("org.kde.KScreen", 1, 0, "OsdAction", [](QQmlEngine *, QJSEngine *) -> QObject * {
         return new KScreen::OsdAction();
     });
+}
 
+OsdManager::OsdManager(QObject *parent)
+    : QObject(parent)
+    , m_cleanupTimer(new QTimer(this))
+{
     // free up memory when the osd hasn't been used for more than 1 minute
     m_cleanupTimer->setInterval(60000);
     m_cleanupTimer->setSingleShot(true);
@@ -122,6 +130,8 @@ OsdAction *OsdManager::showActionSelector()
         if (m_osds.contains(osdOutput->name())) {
             osd = m_osds.value(osdOutput->name());
         } else {
+            // Most sessions never show an OSD.
+            registerQmlTypes();
             osd = new KScreen::Osd(osdOutput, this);
             m_osds.insert(osdOutput->name(), osd);
         }
@@ -29,6 +29,11 @@ public:
     OsdManager(QObject *parent = nullptr);
     ~OsdManager() override;
 
+    /**
+     * Registers the QML types of the OSD, which happens before the first OSD is shown.
+     */
+    static void registerQmlTypes();
+
 public Q_SLOTS:
     void hideOsd();
     KScreen::OsdAction *showActionSelector();
@@ -5,13 +5,18 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "output.h"
+#include "../common/fileformat.h"
+#include "../common/persistence.h"
 #include "config.h"
 
 #include "generator.h"
 #include "kscreen_daemon_debug.h"
+#include "outputdatacache.h"
+#include "outputidentitycache.h"
 
 #include <QDir>
 #include <QFile>
+#include <QHash>
 #include <QJsonDocument>
 #include <QLoggingCategory>
 #include <QRect>
@@ -37,42 +42,83 @@ QString Output::globalFileName(const QString &hash)
     return dir % hash;
 }
 
-static Output::GlobalConfig fromInfo(const KScreen::OutputPtr output, const QVariantMap &info)
+static std::optional<double> numberValue(const QJsonObject &info, const QString &key)
 {
-    Output::GlobalConfig config;
-    bool ok = false;
-    if (int rotation = info.value(QStringLiteral("rotation")).toInt(&ok); ok) {
-        config.rotation = static_cast<KScreen::Output::Rotation>(rotation);
+    const QJsonValue value = info.value(key);
+    if (!value.isDouble()) {
+        return std::nullopt;
     }
+    return value.toDouble();
+}
+
+OutputRecord OutputRecord::fromJson(const QJsonObject &info)
+{
+    OutputRecord record;
+    record.id = info.value(QStringLiteral("id")).toString();
 
-    if (qreal scale = info.value(QStringLiteral("scale")).toDouble(&ok); ok) {
-        config.scale = scale;
+    const QJsonObject metadata = info.value(QStringLiteral("metadata")).toObject();
+    record.name = metadata.value(QStringLiteral("name")).toString();
+    record.fullName = metadata.value(QStringLiteral("fullname")).toString();
+
+    const QJsonValue posValue = info.value(QStringLiteral("pos"));
+    if (posValue.isObject()) {
+        const QJsonObject pos = posValue.toObject();
+        record.pos = QPoint(pos.value(QStringLiteral("x")).toInt(), pos.value(QStringLiteral("y")).toInt());
     }
+    record.primary = info.value(QStringLiteral("primary")).toBool();
+    record.enabled = info.value(QStringLiteral("enabled")).toBool();
 
-    if (auto vrr = static_cast<KScreen::Output::VrrPolicy>(info.value(QStringLiteral("vrrpolicy")).toUInt(&ok)); ok) {
-        config.vrrPolicy = vrr;
+    if (const auto rotation = numberValue(info, QStringLiteral("rotation"))) {
+        record.rotation = static_cast<KScreen::Output::Rotation>(int(*rotation));
+    }
+    record.scale = numberValue(info, QStringLiteral("scale"));
+    if (const auto vrr = numberValue(info, QStringLiteral("vrrpolicy"))) {
+        record.vrrPolicy = static_cast<KScreen::Output::VrrPolicy>(uint32_t(*vrr));
+    }
+    if (const auto overscan = numberValue(info, QStringLiteral("overscan"))) {
+        record.overscan = uint32_t(*overscan);
+    }
+    if (const auto rgbRange = numberValue(info, QStringLiteral("rgbrange"))) {
+        record.rgbRange = static_cast<KScreen::Output::RgbRange>(uint32_t(*rgbRange));
     }
 
-    if (auto overscan = info.value(QStringLiteral("overscan")).toUInt(&ok); ok) {
-        config.overscan = overscan;
+    const QJsonValue modeValue = info.value(QStringLiteral("mode"));
+    if (modeValue.isObject()) {
+        const QJsonObject modeInfo = modeValue.toObject();
+        const QJsonObject modeSize = modeInfo.value(QStringLiteral("size")).toObject();
+        record.modeSize = QSize(modeSize.value(QStringLiteral("width")).toInt(), modeSize.value(QStringLiteral("height")).toInt());
+        record.refreshRate = modeInfo.value(QStringLiteral("refresh")).toDouble();
     }
+    return record;
+}
 
-    if (auto rgbRange = static_cast<KScreen::Output::RgbRange>(info.value(QStringLiteral("rgbrange")).toUInt(&ok)); ok) {
-        config.rgbRange = rgbRange;
+QVector<OutputRecord> OutputRecord::listFromJson(const QJsonArray &outputsInfo)
+{
+    QVector<OutputRecord> records;
+    records.reserve(outputsInfo.size());
+    for (const auto &info : outputsInfo) {
+        records.append(fromJson(info.toObject()));
     }
+    return records;
+}
 
-    const QVariantMap modeInfo = info[QStringLiteral("mode")].toMap();
-    const QVariantMap modeSize = modeInfo[QStringLiteral("size")].toMap();
-    const QSize size = QSize(modeSize[QStringLiteral("width")].toInt(), modeSize[QStringLiteral("height")].toInt());
+static Output::GlobalConfig fromInfo(const KScreen::OutputPtr output, const OutputRecord &info)
+{
+    Output::GlobalConfig config;
+    config.rotation = info.rotation;
+    config.scale = info.scale;
+    config.vrrPolicy = info.vrrPolicy;
+    config.overscan = info.overscan;
+    config.rgbRange = info.rgbRange;
 
-    qCDebug(KSCREEN_KDED) << "Finding a mode for" << size << "@" << modeInfo[QStringLiteral("refresh")].toFloat();
+    qCDebug(KSCREEN_KDED) << "Finding a mode for" << info.modeSize << "@" << info.refreshRate;
 
     const KScreen::ModeList modes = output->modes();
     for (const KScreen::ModePtr &mode : modes) {
-        if (mode->size() != size) {
+        if (mode->size() != info.modeSize) {
             continue;
         }
-        if (!qFuzzyCompare(mode->refreshRate(), modeInfo[QStringLiteral("refresh")].toFloat())) {
+        if (!qFuzzyCompare(mode->refreshRate(), info.refreshRate)) {
             continue;
         }
 
@@ -83,7 +129,7 @@ static Output::GlobalConfig fromInfo(const KScreen::OutputPtr output, const QVar
     return config;
 }
 
-void Output::readInGlobalPartFromInfo(KScreen::OutputPtr output, const QVariantMap &info)
+void Output::readInGlobalPartFromInfo(KScreen::OutputPtr output, const OutputRecord &info)
 {
     GlobalConfig config = fromInfo(output, info);
     output->setRotation(config.rotation.value_or(KScreen::Output::Rotation::None));
@@ -115,37 +161,45 @@ void Output::readInGlobalPartFromInfo(KScreen::OutputPtr output, const QVariantM
     output->setCurrentModeId(matchingMode->id());
 }
 
-QVariantMap Output::getGlobalData(KScreen::OutputPtr output)
+QJsonObject Output::getGlobalData(KScreen::OutputPtr output)
 {
-    QString fileName = Globals::findFile(s_dirName % output->hashMd5());
+    const QString hash = OutputIdentityCache::self()->hashMd5(output);
+    auto *cache = OutputDataCache::self();
+    if (const auto info = cache->info(hash)) {
+        return *info;
+    }
+
+    QString fileName = Globals::findFile(s_dirName % hash);
     if (fileName.isEmpty()) {
-        qCDebug(KSCREEN_KDED) << "No file for" << s_dirName % output->hashMd5();
-        return QVariantMap();
+        qCDebug(KSCREEN_KDED) << "No file for" << s_dirName % hash;
+        cache->insert(hash, QJsonObject(), QString());
+        return QJsonObject();
     }
     QFile file(fileName);
     if (!file.open(QIODevice::ReadOnly)) {
         qCDebug(KSCREEN_KDED) << "Failed to open file" << file.fileName();
-        return QVariantMap();
+        return QJsonObject();
     }
     qCDebug(KSCREEN_KDED) << "Found global data at" << file.fileName();
-    QJsonDocument parser;
-    return parser.fromJson(file.readAll()).toVariant().toMap();
+    const QJsonObject info = FileFormat::decode(file.readAll()).object();
+    cache->insert(hash, info, fileName);
+    return info;
 }
 
 bool Output::readInGlobal(KScreen::OutputPtr output)
 {
-    const QVariantMap info = getGlobalData(output);
-    if (info.empty()) {
+    const QJsonObject info = getGlobalData(output);
+    if (info.isEmpty()) {
         // if info is empty, the global file does not exists, or is in an unreadable state
         return false;
     }
-    readInGlobalPartFromInfo(output, info);
+    readInGlobalPartFromInfo(output, OutputRecord::fromJson(info));
     return true;
 }
 
 Output::GlobalConfig Output::readGlobal(const KScreen::OutputPtr &output)
 {
-    return fromInfo(output, getGlobalData(output));
+    return fromInfo(output, OutputRecord::fromJson(getGlobalData(output)));
 }
 
 KScreen::Output::Rotation orientationToRotation(QOrientationReading::Orientation orientation, KScreen::Output::Rotation fallback)
@@ -185,7 +239,7 @@ bool Output::updateOrientation(KScreen::OutputPtr &output, QOrientationReading::
 }
 
 // TODO: move this into the Layouter class.
-void Output::adjustPositions(KScreen::ConfigPtr config, const QVariantList &outputsInfo)
+void Output::adjustPositions(KScreen::ConfigPtr config, const QMultiHash<QString, const OutputRecord *> &infoById)
 {
     typedef QPair<int, QPoint> Out;
 
@@ -203,51 +257,31 @@ void Output::adjustPositions(KScreen::ConfigPtr config, const QVariantList &outp
     });
 
     for (int cnt = 1; cnt < sortedOutputs.length(); cnt++) {
-        auto getOutputInfoProperties = [outputsInfo](KScreen::OutputPtr output, QRect &geo) -> bool {
+        auto getOutputInfoProperties = [&infoById](KScreen::OutputPtr output, QRect &geo) -> bool {
             if (!output) {
                 return false;
             }
-            const auto hash = output->hash();
-
-            auto it = std::find_if(outputsInfo.begin(), outputsInfo.end(), [hash](QVariant v) {
-                const QVariantMap info = v.toMap();
-                return info[QStringLiteral("id")].toString() == hash;
-            });
-            if (it == outputsInfo.end()) {
+            // The first entry in the config file with this id.
+            const OutputRecord *it = infoById.value(OutputIdentityCache::self()->hash(output));
+            if (!it) {
                 return false;
             }
 
-            auto isPortrait = [](const QVariant &info) {
-                bool ok;
-                const int rot = info.toInt(&ok);
-                if (!ok) {
-                    return false;
-                }
-                return rot & KScreen::Output::Rotation::Left || rot & KScreen::Output::Rotation::Right;
-            };
-
-            const QVariantMap outputInfo = it->toMap();
+            const bool portrait = it->rotation && (*it->rotation & KScreen::Output::Rotation::Left || *it->rotation & KScreen::Output::Rotation::Right);
 
-            const QVariantMap posInfo = outputInfo[QStringLiteral("pos")].toMap();
-            const QVariant scaleInfo = outputInfo[QStringLiteral("scale")];
-            const QVariantMap modeInfo = outputInfo[QStringLiteral("mode")].toMap();
-            const QVariantMap modeSize = modeInfo[QStringLiteral("size")].toMap();
-            const bool portrait = isPortrait(outputInfo[QStringLiteral("rotation")]);
-
-            if (posInfo.isEmpty() || modeSize.isEmpty() || !scaleInfo.canConvert<int>()) {
+            if (!it->pos || !it->modeSize.isValid() || !it->scale) {
                 return false;
             }
 
-            const qreal scale = scaleInfo.toDouble();
+            const qreal scale = *it->scale;
             if (scale <= 0) {
                 return false;
             }
-            const QPoint pos = QPoint(posInfo[QStringLiteral("x")].toInt(), posInfo[QStringLiteral("y")].toInt());
-            QSize size = QSize(modeSize[QStringLiteral("width")].toInt() / scale, modeSize[QStringLiteral("height")].toInt() / scale);
+            QSize size = QSize(it->modeSize.width() / scale, it->modeSize.height() / scale);
             if (portrait) {
                 size.transpose();
             }
-            geo = QRect(pos, size);
+            geo = QRect(*it->pos, size);
 
             return true;
         };
@@ -327,13 +361,11 @@ void Output::adjustPositions(KScreen::ConfigPtr config, const QVariantList &outp
     }
 }
 
-void Output::readIn(KScreen::OutputPtr output, const QVariantMap &info, Control::OutputRetention retention)
+void Output::readIn(KScreen::OutputPtr output, const OutputRecord &info, Control::OutputRetention retention)
 {
-    const QVariantMap posInfo = info[QStringLiteral("pos")].toMap();
-    QPoint point(posInfo[QStringLiteral("x")].toInt(), posInfo[QStringLiteral("y")].toInt());
-    output->setPos(point);
-    output->setPrimary(info[QStringLiteral("primary")].toBool());
-    output->setEnabled(info[QStringLiteral("enabled")].toBool());
+    output->setPos(info.pos.value_or(QPoint(0, 0)));
+    output->setPrimary(info.primary);
+    output->setEnabled(info.enabled);
 
     if (retention != Control::OutputRetention::Individual && readInGlobal(output)) {
         // output data read from global output file
@@ -343,23 +375,23 @@ void Output::readIn(KScreen::OutputPtr output, const QVariantMap &info, Control:
     readInGlobalPartFromInfo(output, info);
 }
 
-void Output::readInOutputs(KScreen::ConfigPtr config, const QVariantList &outputsInfo)
+void Output::readInOutputs(KScreen::ConfigPtr config, const QVector<OutputRecord> &outputsInfo, const ControlConfig &control)
 {
     const KScreen::OutputList outputs = config->outputs();
-    ControlConfig control(config);
     // As global outputs are indexed by a hash of their edid, which is not unique,
     // to be able to tell apart multiple identical outputs, these need special treatment
-    QStringList duplicateIds;
-    {
-        QStringList allIds;
-        allIds.reserve(outputs.count());
-        for (const KScreen::OutputPtr &output : outputs) {
-            const auto outputId = output->hash();
-            if (allIds.contains(outputId) && !duplicateIds.contains(outputId)) {
-                duplicateIds << outputId;
-            }
-            allIds << outputId;
-        }
+    QHash<QString, int> idCounts;
+    idCounts.reserve(outputs.count());
+    for (const KScreen::OutputPtr &output : outputs) {
+        idCounts[OutputIdentityCache::self()->hash(output)]++;
+    }
+
+    // QMultiHash returns the most recently inserted value first, insert backwards to match
+    // against the entries in the order of the config file.
+    QMultiHash<QString, const OutputRecord *> infoById;
+    infoById.reserve(outputsInfo.size());
+    for (auto it = outputsInfo.crbegin(); it != outputsInfo.crend(); ++it) {
+        infoById.insert(it->id, &*it);
     }
 
     for (const KScreen::OutputPtr &output : outputs) {
@@ -367,41 +399,35 @@ void Output::readInOutputs(KScreen::ConfigPtr config, const QVariantList &output
             output->setEnabled(false);
             continue;
         }
-        const auto outputId = output->hash();
-        bool infoFound = false;
-        for (const auto &variantInfo : outputsInfo) {
-            const QVariantMap info = variantInfo.toMap();
-            if (outputId != info[QStringLiteral("id")].toString()) {
+        const auto outputId = OutputIdentityCache::self()->hash(output);
+        const bool isDuplicate = !output->name().isEmpty() && idCounts.value(outputId) > 1;
+        const OutputRecord *matchingInfo = nullptr;
+        for (auto it = infoById.constFind(outputId); it != infoById.constEnd() && it.key() == outputId; ++it) {
+            // We may have identical outputs connected, these will have the same id in the config
+            // in order to find the right one, also check the output's name (usually the connector)
+            if (isDuplicate && output->name() != (*it)->name) {
+                // was a duplicate id, but info not for this output
                 continue;
             }
-            if (!output->name().isEmpty() && duplicateIds.contains(outputId)) {
-                // We may have identical outputs connected, these will have the same id in the config
-                // in order to find the right one, also check the output's name (usually the connector)
-                const auto metadata = info[QStringLiteral("metadata")].toMap();
-                const auto outputName = metadata[QStringLiteral("name")].toString();
-                if (output->name() != outputName) {
-                    // was a duplicate id, but info not for this output
-                    continue;
-                }
-            }
-            infoFound = true;
-            readIn(output, info, control.getOutputRetention(output));
+            matchingInfo = *it;
             break;
         }
-        if (!infoFound) {
+        if (matchingInfo) {
+            readIn(output, *matchingInfo, control.getOutputRetention(output));
+        } else {
             // no info in info for this output, try reading in global output info at least or set some default values
 
             qCWarning(KSCREEN_KDED) << "\tFailed to find a matching output in the current info data - this means that our info is corrupted"
                                        "or a different device with the same serial number has been connected (very unlikely).";
             if (!readInGlobal(output)) {
                 // set some default values instead
-                readInGlobalPartFromInfo(output, QVariantMap());
+                readInGlobalPartFromInfo(output, OutputRecord());
             }
         }
     }
 
     for (KScreen::OutputPtr output : outputs) {
-        auto replicationSource = control.getReplicationSource(output);
+        auto replicationSource = control.getReplicationSource(config, output);
         if (replicationSource) {
             output->setPos(replicationSource->pos());
             output->setExplicitLogicalSize(config->logicalSizeForOutput(*replicationSource));
@@ -413,13 +439,13 @@ void Output::readInOutputs(KScreen::ConfigPtr config, const QVariantList &output
     // TODO: this does not work at the moment with logical size replication. Deactivate for now.
     // correct positional config regressions on global output data changes
 #if 0
-    adjustPositions(config, outputsInfo);
+    adjustPositions(config, infoById);
 #endif
 }
 
-static QVariantMap metadata(const KScreen::OutputPtr &output)
+static QJsonObject metadata(const KScreen::OutputPtr &output)
 {
-    QVariantMap metadata;
+    QJsonObject metadata;
     metadata[QStringLiteral("name")] = output->name();
     if (!output->edid() || !output->edid()->isValid()) {
         return metadata;
@@ -429,16 +455,16 @@ static QVariantMap metadata(const KScreen::OutputPtr &output)
     return metadata;
 }
 
-bool Output::writeGlobalPart(const KScreen::OutputPtr &output, QVariantMap &info, const KScreen::OutputPtr &fallback)
+bool Output::writeGlobalPart(const KScreen::OutputPtr &output, QJsonObject &info, const KScreen::OutputPtr &fallback)
 {
-    info[QStringLiteral("id")] = output->hash();
+    info[QStringLiteral("id")] = OutputIdentityCache::self()->hash(output);
     info[QStringLiteral("metadata")] = metadata(output);
-    info[QStringLiteral("rotation")] = output->rotation();
+    info[QStringLiteral("rotation")] = static_cast<int>(output->rotation());
 
     // Round scale to four digits
     info[QStringLiteral("scale")] = int(output->scale() * 10000 + 0.5) / 10000.;
 
-    QVariantMap modeInfo;
+    QJsonObject modeInfo;
     float refreshRate = -1.;
     QSize modeSize;
     if (output->currentMode() && output->isEnabled()) {
@@ -453,17 +479,17 @@ bool Output::writeGlobalPart(const KScreen::OutputPtr &output, QVariantMap &info
         return false;
     }
 
-    modeInfo[QStringLiteral("refresh")] = refreshRate;
+    modeInfo[QStringLiteral("refresh")] = double(refreshRate);
 
-    QVariantMap modeSizeMap;
+    QJsonObject modeSizeMap;
     modeSizeMap[QStringLiteral("width")] = modeSize.width();
     modeSizeMap[QStringLiteral("height")] = modeSize.height();
     modeInfo[QStringLiteral("size")] = modeSizeMap;
 
     info[QStringLiteral("mode")] = modeInfo;
-    info[QStringLiteral("vrrpolicy")] = static_cast<uint32_t>(output->vrrPolicy());
-    info[QStringLiteral("overscan")] = output->overscan();
-    info[QStringLiteral("rgbrange")] = static_cast<uint32_t>(output->rgbRange());
+    info[QStringLiteral("vrrpolicy")] = static_cast<int>(output->vrrPolicy());
+    info[QStringLiteral("overscan")] = static_cast<int>(output->overscan());
+    info[QStringLiteral("rgbrange")] = static_cast<int>(output->rgbRange());
 
     return true;
 }
@@ -471,17 +497,16 @@ bool Output::writeGlobalPart(const KScreen::OutputPtr &output, QVariantMap &info
 void Output::writeGlobal(const KScreen::OutputPtr &output)
 {
     // get old values and subsequently override
-    QVariantMap info = getGlobalData(output);
-    if (!writeGlobalPart(output, info, nullptr)) {
+    const QJsonObject oldInfo = getGlobalData(output);
+    QJsonObject info = oldInfo;
+    if (!writeGlobalPart(output, info, nullptr) || info == oldInfo) {
         return;
     }
 
-    QFile file(globalFileName(output->hashMd5()));
-    if (!file.open(QIODevice::WriteOnly)) {
-        qCWarning(KSCREEN_KDED) << "Failed to open global output file for writing! " << file.errorString();
+    const QString hash = OutputIdentityCache::self()->hashMd5(output);
+    if (!Persistence::self()->write(globalFileName(hash), FileFormat::encode(QJsonDocument(info)))) {
+        qCWarning(KSCREEN_KDED) << "Failed to write global output file for" << hash;
         return;
     }
-
-    file.write(QJsonDocument::fromVariant(info).toJson());
-    return;
+    OutputDataCache::self()->insertWritten(hash, info);
 }
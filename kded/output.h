@@ -13,18 +13,49 @@
 #include <kscreen/output.h>
 #include <kscreen/types.h>
 
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
 #include <QOrientationReading>
-#include <QVariantMap>
+#include <QPoint>
+#include <QSize>
+#include <QVector>
 
 #include <optional>
 
+/**
+ * One output entry of a stored config or a global output file, parsed in one pass from its JSON object.
+ */
+struct OutputRecord {
+    QString id;
+    QString name;
+    QString fullName;
+
+    std::optional<QPoint> pos;
+    bool primary = false;
+    bool enabled = false;
+
+    std::optional<KScreen::Output::Rotation> rotation;
+    std::optional<qreal> scale;
+    std::optional<KScreen::Output::VrrPolicy> vrrPolicy;
+    std::optional<uint32_t> overscan;
+    std::optional<KScreen::Output::RgbRange> rgbRange;
+
+    // Invalid if the entry has no mode
+    QSize modeSize;
+    float refreshRate = 0;
+
+    static OutputRecord fromJson(const QJsonObject &info);
+    static QVector<OutputRecord> listFromJson(const QJsonArray &outputsInfo);
+};
+
 class Output
 {
 public:
-    static void readInOutputs(KScreen::ConfigPtr config, const QVariantList &outputsInfo);
+    static void readInOutputs(KScreen::ConfigPtr config, const QVector<OutputRecord> &outputsInfo, const ControlConfig &control);
 
     static void writeGlobal(const KScreen::OutputPtr &output);
-    static bool writeGlobalPart(const KScreen::OutputPtr &output, QVariantMap &info, const KScreen::OutputPtr &fallback);
+    static bool writeGlobalPart(const KScreen::OutputPtr &output, QJsonObject &info, const KScreen::OutputPtr &fallback);
 
     static QString dirPath();
 
@@ -41,17 +72,19 @@ public:
     static GlobalConfig readGlobal(const KScreen::OutputPtr &output);
 
 private:
+    friend class TopologyCache;
+
     static QString globalFileName(const QString &hash);
-    static QVariantMap getGlobalData(KScreen::OutputPtr output);
+    static QJsonObject getGlobalData(KScreen::OutputPtr output);
 
-    static void readIn(KScreen::OutputPtr output, const QVariantMap &info, Control::OutputRetention retention);
+    static void readIn(KScreen::OutputPtr output, const OutputRecord &info, Control::OutputRetention retention);
     static bool readInGlobal(KScreen::OutputPtr output);
-    static void readInGlobalPartFromInfo(KScreen::OutputPtr output, const QVariantMap &info);
+    static void readInGlobalPartFromInfo(KScreen::OutputPtr output, const OutputRecord &info);
     /*
      * When a global output value (scale, rotation) is changed we might
      * need to reposition the outputs when another config is read.
      */
-    static void adjustPositions(KScreen::ConfigPtr config, const QVariantList &outputsInfo);
+    static void adjustPositions(KScreen::ConfigPtr config, const QMultiHash<QString, const OutputRecord *> &infoById);
 
     static QString s_dirName;
 };
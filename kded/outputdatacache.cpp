@@ -0,0 +1,109 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "outputdatacache.h"
+#include "../common/globals.h"
+#include "kscreen_daemon_debug.h"
+#include "output.h"
+
+#include <QFileInfo>
+#include <QStringBuilder>
+
+OutputDataCache::OutputDataCache()
+    : QObject()
+{
+    connect(Persistence::self(), &Persistence::written, this, &OutputDataCache::fileWritten);
+}
+
+OutputDataCache::~OutputDataCache()
+{
+    qCDebug(KSCREEN_KDED) << "Output data cache hits:" << m_hits << "misses:" << m_misses;
+}
+
+std::optional<QJsonObject> OutputDataCache::info(const QString &hash)
+{
+    const auto it = m_entries.constFind(hash);
+    if (it == m_entries.constEnd()) {
+        m_misses++;
+        return std::nullopt;
+    }
+    if (!isCurrent(hash, *it)) {
+        qCDebug(KSCREEN_KDED) << "Global output data of" << hash << "changed, dropping it from the output data cache";
+        m_entries.erase(it);
+        m_misses++;
+        return std::nullopt;
+    }
+    m_hits++;
+    return it->info;
+}
+
+bool OutputDataCache::isCurrent(const QString &hash, const Entry &entry) const
+{
+    if (Persistence::self()->isPending(entry.filePath)) {
+        // Our own write, newer than anything on disk.
+        return true;
+    }
+    const QString localPath = Output::dirPath() % hash;
+    const QFileInfo localInfo(localPath);
+    if (entry.filePath == localPath) {
+        return localInfo.exists() && FileStamp::of(localInfo) == entry.stamp;
+    }
+    if (localInfo.exists()) {
+        // Overrides the preset, or the lack of any file, the entry was read from.
+        return false;
+    }
+    if (entry.presetsSerial != Globals::presetsSerial()) {
+        return false;
+    }
+    return entry.filePath.isEmpty() || FileStamp::of(QFileInfo(entry.filePath)) == entry.stamp;
+}
+
+void OutputDataCache::insert(const QString &hash, const QJsonObject &info, const QString &filePath)
+{
+    Entry entry;
+    entry.info = info;
+    entry.filePath = filePath;
+    if (!filePath.isEmpty()) {
+        entry.stamp = FileStamp::of(QFileInfo(filePath));
+    }
+    entry.presetsSerial = Globals::presetsSerial();
+    m_entries.insert(hash, entry);
+}
+
+void OutputDataCache::insertWritten(const QString &hash, const QJsonObject &info)
+{
+    const QString filePath = Output::dirPath() % hash;
+    if (!Persistence::self()->isAsynchronous()) {
+        insert(hash, info, filePath);
+        return;
+    }
+    Entry entry;
+    entry.info = info;
+    entry.filePath = filePath;
+    m_entries.insert(hash, entry);
+}
+
+void OutputDataCache::clear()
+{
+    m_entries.clear();
+}
+
+void OutputDataCache::fileWritten(const QString &path, bool success)
+{
+    const QString dirPath = Output::dirPath();
+    if (!path.startsWith(dirPath)) {
+        return;
+    }
+    const auto it = m_entries.find(path.mid(dirPath.size()));
+    if (it == m_entries.end() || it->filePath != path || Persistence::self()->isPending(path)) {
+        // Wait for the last of our writes to the file.
+        return;
+    }
+    if (!success) {
+        m_entries.erase(it);
+        return;
+    }
+    it->stamp = FileStamp::of(QFileInfo(path));
+}
@@ -0,0 +1,65 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_OUTPUTDATACACHE_H
+#define KDED_OUTPUTDATACACHE_H
+
+#include "../common/persistence.h"
+#include "../common/singleton.h"
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+
+#include <optional>
+
+/**
+ * Per-process cache of the global output data, keyed by the output's EDID hash
+ * (KScreen::Output::hashMd5()).
+ *
+ * An entry remembers which file it was read from, a file in Output::dirPath() or a preset, and
+ * that file's stamp. It is dropped on lookup once that file changed, a file in Output::dirPath()
+ * overrides it or the presets changed, so a lookup costs a stat or two instead of reading and
+ * parsing. Outputs without a global file are cached as an empty object. Writes of the daemon
+ * itself update the cache in place.
+ */
+class OutputDataCache : public QObject, public Singleton<OutputDataCache>
+{
+    Q_OBJECT
+public:
+    std::optional<QJsonObject> info(const QString &hash);
+    /**
+     * Caches @p info as read from @p filePath, which is empty if there is no file for @p hash.
+     */
+    void insert(const QString &hash, const QJsonObject &info, const QString &filePath);
+    /**
+     * Caches @p info which was just handed to Persistence for writing to Output::dirPath().
+     */
+    void insertWritten(const QString &hash, const QJsonObject &info);
+    void clear();
+
+private:
+    friend class Singleton<OutputDataCache>;
+    explicit OutputDataCache();
+    ~OutputDataCache() override;
+
+    void fileWritten(const QString &path, bool success);
+
+    struct Entry {
+        QJsonObject info;
+        QString filePath;
+        // Invalid until our own write of the info is done.
+        FileStamp stamp;
+        // Of the presets, when the entry is for a preset or no file at all
+        quint64 presetsSerial = 0;
+    };
+    bool isCurrent(const QString &hash, const Entry &entry) const;
+
+    QHash<QString, Entry> m_entries;
+    int m_hits = 0;
+    int m_misses = 0;
+};
+
+#endif
@@ -0,0 +1,50 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "outputidentitycache.h"
+#include "kscreen_daemon_debug.h"
+
+#include <kscreen/edid.h>
+#include <kscreen/output.h>
+
+static uint edidFingerprint(const KScreen::OutputPtr &output)
+{
+    const KScreen::Edid *edid = output->edid();
+    if (!edid || !edid->isValid()) {
+        return 0;
+    }
+    return qHash(edid->rawData());
+}
+
+OutputIdentityCache::~OutputIdentityCache()
+{
+    qCDebug(KSCREEN_KDED) << "Output identity cache hits:" << m_hits << "misses:" << m_misses;
+}
+
+QString OutputIdentityCache::hash(const KScreen::OutputPtr &output)
+{
+    return entry(output).hash;
+}
+
+QString OutputIdentityCache::hashMd5(const KScreen::OutputPtr &output)
+{
+    return entry(output).hashMd5;
+}
+
+const OutputIdentityCache::Entry &OutputIdentityCache::entry(const KScreen::OutputPtr &output)
+{
+    const uint fingerprint = edidFingerprint(output);
+    auto it = m_entries.find(output->name());
+    if (it != m_entries.end() && it->edidFingerprint == fingerprint) {
+        m_hits++;
+        return *it;
+    }
+    m_misses++;
+    Entry entry;
+    entry.edidFingerprint = fingerprint;
+    entry.hash = output->hash();
+    entry.hashMd5 = output->hashMd5();
+    return *m_entries.insert(output->name(), entry);
+}
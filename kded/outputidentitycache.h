@@ -0,0 +1,45 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_OUTPUTIDENTITYCACHE_H
+#define KDED_OUTPUTIDENTITYCACHE_H
+
+#include "../common/singleton.h"
+
+#include <kscreen/config.h>
+
+#include <QHash>
+#include <QString>
+
+/**
+ * The identities of outputs (KScreen::Output::hash() and hashMd5()) by connector name.
+ *
+ * Both are derived from the EDID, which is hashed for every call. An entry is reused for as long as
+ * the connector reports the same EDID, checked through a cheap fingerprint of the raw EDID data.
+ */
+class OutputIdentityCache : public Singleton<OutputIdentityCache>
+{
+public:
+    QString hash(const KScreen::OutputPtr &output);
+    QString hashMd5(const KScreen::OutputPtr &output);
+
+private:
+    friend class Singleton<OutputIdentityCache>;
+    OutputIdentityCache() = default;
+    ~OutputIdentityCache();
+
+    struct Entry {
+        uint edidFingerprint = 0;
+        QString hash;
+        QString hashMd5;
+    };
+    const Entry &entry(const KScreen::OutputPtr &output);
+
+    QHash<QString, Entry> m_entries;
+    int m_hits = 0;
+    int m_misses = 0;
+};
+
+#endif
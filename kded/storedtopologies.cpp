@@ -0,0 +1,150 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "storedtopologies.h"
+#include "../common/fileformat.h"
+#include "../common/persistence.h"
+#include "config.h"
+#include "configcache.h"
+#include "configstore.h"
+#include "kscreen_daemon_debug.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringBuilder>
+
+StoredTopologies::StoredTopologies()
+    : QObject()
+{
+    readIndex();
+    connect(ConfigCache::self(), &ConfigCache::storedConfigsChanged, this, &StoredTopologies::configChanged);
+    connect(ConfigCache::self(), &ConfigCache::storedConfigWritten, this, &StoredTopologies::configChanged);
+}
+
+void StoredTopologies::configChanged(const QString &name)
+{
+    if (name.isEmpty()) {
+        m_checkStamps = true;
+        return;
+    }
+    // Neither is a stored config, just like in Config::storedConfigNames().
+    if (name != Config::s_fixedConfigFileName && name != ConfigStore::fileName()) {
+        m_changed.insert(name);
+    }
+}
+
+QString StoredTopologies::filePath() const
+{
+    return Config::configsDirPath() % QStringLiteral(".topologies");
+}
+
+QString StoredTopologies::stamp(const QString &name)
+{
+    if (auto *store = ConfigStore::self()) {
+        // Records are in memory already, hashing one is still a lot cheaper than parsing it.
+        return QString::fromLatin1(QCryptographicHash::hash(store->value(name), QCryptographicHash::Md5).toHex());
+    }
+    const FileStamp fileStamp = FileStamp::of(QFileInfo(Config::configsDirPath() % name));
+    return QString::number(fileStamp.lastModified.toMSecsSinceEpoch()) % QLatin1Char('-') % QString::number(fileStamp.size);
+}
+
+void StoredTopologies::readIndex()
+{
+    QFile file(filePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QJsonObject index = FileFormat::decode(file.readAll()).object();
+    for (auto it = index.constBegin(); it != index.constEnd(); ++it) {
+        const QJsonObject entry = it.value().toObject();
+        m_entries.insert(it.key(), {entry.value(QStringLiteral("stamp")).toString(), OutputRecord::listFromJson(entry.value(QStringLiteral("outputs")).toArray())});
+    }
+}
+
+void StoredTopologies::writeIndex()
+{
+    QJsonObject index;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        QJsonArray outputs;
+        for (const OutputRecord &record : it->outputs) {
+            // Same keys as in the stored configs.
+            outputs.append(QJsonObject{{QStringLiteral("id"), record.id},
+                                       {QStringLiteral("metadata"), QJsonObject{{QStringLiteral("name"), record.name}}},
+                                       {QStringLiteral("enabled"), record.enabled}});
+        }
+        index.insert(it.key(), QJsonObject{{QStringLiteral("stamp"), it->stamp}, {QStringLiteral("outputs"), outputs}});
+    }
+    Persistence::self()->write(filePath(), FileFormat::encode(QJsonDocument(index)));
+}
+
+std::optional<StoredTopologies::Entry> StoredTopologies::readEntry(const QString &name)
+{
+    // Taken before reading, a change in between is then caught on the next check.
+    const QString currentStamp = stamp(name);
+    const auto records = Config::storedOutputs(name);
+    if (!records) {
+        return std::nullopt;
+    }
+    Entry entry;
+    entry.stamp = currentStamp;
+    entry.outputs.reserve(records->size());
+    for (const OutputRecord &record : *records) {
+        OutputRecord output;
+        output.id = record.id;
+        output.name = record.name;
+        output.enabled = record.enabled;
+        entry.outputs << output;
+    }
+    return entry;
+}
+
+QHash<QString, QVector<OutputRecord>> StoredTopologies::outputs()
+{
+    bool changed = false;
+    if (m_checkStamps) {
+        QHash<QString, Entry> entries;
+        const QStringList names = Config::storedConfigNames();
+        entries.reserve(names.size());
+        for (const QString &name : names) {
+            const auto it = m_entries.constFind(name);
+            if (it != m_entries.constEnd() && !m_changed.contains(name) && it->stamp == stamp(name)) {
+                entries.insert(name, *it);
+                continue;
+            }
+            changed = true;
+            if (auto entry = readEntry(name)) {
+                entries.insert(name, *entry);
+            }
+        }
+        changed |= entries.size() != m_entries.size();
+        m_entries = std::move(entries);
+        m_checkStamps = false;
+    } else {
+        for (const QString &name : qAsConst(m_changed)) {
+            changed = true;
+            if (auto entry = readEntry(name)) {
+                m_entries.insert(name, *entry);
+            } else {
+                m_entries.remove(name);
+            }
+        }
+    }
+    m_changed.clear();
+    if (changed) {
+        qCDebug(KSCREEN_KDED) << "Updated the outputs of the stored configs";
+        writeIndex();
+    }
+
+    QHash<QString, QVector<OutputRecord>> outputs;
+    outputs.reserve(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        outputs.insert(it.key(), it->outputs);
+    }
+    return outputs;
+}
@@ -0,0 +1,61 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_STOREDTOPOLOGIES_H
+#define KDED_STOREDTOPOLOGIES_H
+
+#include "../common/singleton.h"
+#include "output.h"
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include <optional>
+
+/**
+ * Index of the outputs in every stored config, to find the stored config closest to a new
+ * combination of outputs without reading and parsing all of them.
+ *
+ * Only the id, name and enabled state of the outputs are kept, along with a stamp of the stored
+ * config they were read from. The stamps are checked once after the index was read, for changes
+ * while the daemon was not running. From then on only the stored configs ConfigCache reports as
+ * changed are read again. The index is kept in a hidden file next to the configs.
+ */
+class StoredTopologies : public QObject, public Singleton<StoredTopologies>
+{
+    Q_OBJECT
+public:
+    /**
+     * The outputs of all stored configs by config name, with only id, name and enabled set.
+     */
+    QHash<QString, QVector<OutputRecord>> outputs();
+
+private:
+    friend class Singleton<StoredTopologies>;
+    StoredTopologies();
+
+    QString filePath() const;
+    void readIndex();
+    void writeIndex();
+    void configChanged(const QString &name);
+    static QString stamp(const QString &name);
+
+    struct Entry {
+        QString stamp;
+        QVector<OutputRecord> outputs;
+    };
+    static std::optional<Entry> readEntry(const QString &name);
+
+    QHash<QString, Entry> m_entries;
+    // Stored configs to read again on next use
+    QSet<QString> m_changed;
+    // Whether all stored configs need to be checked against their stamps on next use
+    bool m_checkStamps = true;
+};
+
+#endif
@@ -0,0 +1,140 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "topologycache.h"
+#include "config.h"
+#include "configcache.h"
+#include "device.h"
+#include "kscreen_daemon_debug.h"
+#include "output.h"
+#include "outputidentitycache.h"
+
+#include <kscreen/output.h>
+
+static const int s_maxEntries = 8;
+
+bool TopologyCache::Key::operator==(const Key &other) const
+{
+    return outputsHash == other.outputsHash && lidClosed == other.lidClosed && docked == other.docked && tabletMode == other.tabletMode
+        && orientation == other.orientation;
+}
+
+uint qHash(const TopologyCache::Key &key, uint seed)
+{
+    const uint flags = uint(key.lidClosed) | uint(key.docked) << 1 | uint(key.tabletMode) << 2 | uint(key.orientation) << 3;
+    return qHash(key.outputsHash, seed) ^ flags;
+}
+
+TopologyCache::TopologyCache(QObject *parent)
+    : QObject(parent)
+{
+    connect(ConfigCache::self(), &ConfigCache::storedConfigsChanged, this, &TopologyCache::storedConfigChanged);
+}
+
+TopologyCache::~TopologyCache()
+{
+    qCDebug(KSCREEN_KDED) << "Topology cache hits:" << m_hits << "misses:" << m_misses;
+}
+
+std::optional<TopologyCache::Key> TopologyCache::key(const KScreen::ConfigPtr &config, QOrientationReading::Orientation orientation)
+{
+    if (!Device::self()->isReady()) {
+        // Lid and dock state are still unknown.
+        return std::nullopt;
+    }
+    Key key;
+    key.outputsHash = config->connectedOutputsHash();
+    key.lidClosed = Device::self()->isLidClosed();
+    key.docked = Device::self()->isDocked();
+    key.tabletMode = config->tabletModeEngaged();
+    key.orientation = orientation;
+    return key;
+}
+
+KScreen::ConfigPtr TopologyCache::find(const Key &key, const KScreen::ConfigPtr &liveConfig)
+{
+    const auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd()) {
+        m_misses++;
+        return KScreen::ConfigPtr();
+    }
+    const KScreen::ConfigPtr config = it->config;
+
+    // The backend may have handed out new ids to the same outputs, for example behind an MST hub.
+    const KScreen::OutputList liveOutputs = liveConfig->outputs();
+    const KScreen::OutputList outputs = config->outputs();
+    for (const KScreen::OutputPtr &output : outputs) {
+        const KScreen::OutputPtr liveOutput = liveOutputs.value(output->id());
+        auto *identities = OutputIdentityCache::self();
+        if (!liveOutput || liveOutput->isConnected() != output->isConnected()
+            || (output->isConnected() && identities->hash(liveOutput) != identities->hash(output))) {
+            qCDebug(KSCREEN_KDED) << "Cached config does not fit the current outputs anymore";
+            m_entries.remove(key);
+            m_order.removeOne(key);
+            m_misses++;
+            return KScreen::ConfigPtr();
+        }
+        // A stat or two per output, the global data is cached and checked against its file.
+        if (output->isConnected() && Output::getGlobalData(liveOutput) != it->globalData.value(identities->hashMd5(liveOutput))) {
+            qCDebug(KSCREEN_KDED) << "Global data of" << output->name() << "changed since its config was cached";
+            m_entries.remove(key);
+            m_order.removeOne(key);
+            m_misses++;
+            return KScreen::ConfigPtr();
+        }
+    }
+
+    m_hits++;
+    m_order.removeOne(key);
+    m_order.append(key);
+    qCDebug(KSCREEN_KDED) << "Topology cache hit - hits:" << m_hits << "misses:" << m_misses;
+    return config->clone();
+}
+
+void TopologyCache::insert(const Key &key, const KScreen::ConfigPtr &config)
+{
+    m_order.removeOne(key);
+    m_order.append(key);
+    Entry entry;
+    entry.config = config->clone();
+    const KScreen::OutputList outputs = config->outputs();
+    for (const KScreen::OutputPtr &output : outputs) {
+        if (output->isConnected()) {
+            entry.globalData.insert(OutputIdentityCache::self()->hashMd5(output), Output::getGlobalData(output));
+        }
+    }
+    m_entries.insert(key, entry);
+    while (m_order.count() > s_maxEntries) {
+        m_entries.remove(m_order.takeFirst());
+    }
+}
+
+void TopologyCache::storedConfigChanged(const QString &fileName)
+{
+    if (fileName.isEmpty()) {
+        clear();
+        return;
+    }
+    // The config for the open lid belongs to the same outputs.
+    const QString outputsHash = fileName.endsWith(Config::s_openLidSuffix) ? fileName.chopped(Config::s_openLidSuffix.size()) : fileName;
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it.key().outputsHash == outputsHash) {
+            qCDebug(KSCREEN_KDED) << "Stored config" << fileName << "changed, dropping it from the topology cache";
+            m_order.removeOne(it.key());
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TopologyCache::clear()
+{
+    if (!m_entries.isEmpty()) {
+        qCDebug(KSCREEN_KDED) << "Clearing topology cache";
+    }
+    m_entries.clear();
+    m_order.clear();
+}
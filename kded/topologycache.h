@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KDED_TOPOLOGYCACHE_H
+#define KDED_TOPOLOGYCACHE_H
+
+#include <kscreen/config.h>
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QOrientationReading>
+
+#include <optional>
+
+/**
+ * Backend-ready configs of recently seen device states.
+ *
+ * A state is made up of the connected outputs, the lid, the dock, the device orientation and the
+ * tablet mode. Returning to a state whose config was applied before then skips reading, parsing
+ * and generating the config again. An entry is dropped when the stored config of its outputs
+ * changes behind the daemon's back, or the global data of one of its outputs changed since.
+ */
+class TopologyCache : public QObject
+{
+    Q_OBJECT
+public:
+    struct Key {
+        QString outputsHash;
+        bool lidClosed = false;
+        bool docked = false;
+        bool tabletMode = false;
+        QOrientationReading::Orientation orientation = QOrientationReading::Undefined;
+
+        bool operator==(const Key &other) const;
+    };
+
+    explicit TopologyCache(QObject *parent = nullptr);
+    ~TopologyCache() override;
+
+    /**
+     * The current state of @p config with the device in @p orientation, unless the state of the
+     * device is not known yet.
+     */
+    static std::optional<Key> key(const KScreen::ConfigPtr &config, QOrientationReading::Orientation orientation);
+
+    /**
+     * A copy of the config cached for @p key, if it still fits the outputs of @p liveConfig.
+     */
+    KScreen::ConfigPtr find(const Key &key, const KScreen::ConfigPtr &liveConfig);
+    void insert(const Key &key, const KScreen::ConfigPtr &config);
+    void clear();
+
+private:
+    void storedConfigChanged(const QString &fileName);
+
+    struct Entry {
+        KScreen::ConfigPtr config;
+        // Global data of the connected outputs by their hash, as the config was made with
+        QHash<QString, QJsonObject> globalData;
+    };
+    QHash<Key, Entry> m_entries;
+    // Least recently used first
+    QList<Key> m_order;
+    int m_hits = 0;
+    int m_misses = 0;
+};
+
+uint qHash(const TopologyCache::Key &key, uint seed = 0);
+
+#endif
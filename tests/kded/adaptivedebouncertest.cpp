@@ -0,0 +1,145 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../kded/adaptivedebouncer.h"
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QtTest>
+
+using namespace std::chrono_literals;
+
+class TestAdaptiveDebouncer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testTrailingEdge();
+    void testLearnWindow();
+    void testMaxWindow();
+    void testDecay();
+    void testSlowestSourceDecides();
+
+private:
+    void learnWindow(AdaptiveDebouncer &debouncer, QSignalSpy &triggeredSpy, int gapMs);
+};
+
+void TestAdaptiveDebouncer::initTestCase()
+{
+    qputenv("KSCREEN_LOGGING", "false");
+}
+
+void TestAdaptiveDebouncer::learnWindow(AdaptiveDebouncer &debouncer, QSignalSpy &triggeredSpy, int gapMs)
+{
+    // A second event shortly after the burst was considered over belongs to the same burst.
+    const int count = triggeredSpy.count();
+    debouncer.event(QStringLiteral("a"));
+    QTRY_COMPARE(triggeredSpy.count(), count + 1);
+    QTest::qWait(gapMs);
+    debouncer.event(QStringLiteral("a"));
+    QTRY_COMPARE_WITH_TIMEOUT(triggeredSpy.count(), count + 2, 2000);
+}
+
+void TestAdaptiveDebouncer::testTrailingEdge()
+{
+    AdaptiveDebouncer debouncer(100ms, 500ms);
+    QSignalSpy triggeredSpy(&debouncer, &AdaptiveDebouncer::triggered);
+    QCOMPARE(debouncer.window(QStringLiteral("a")), 100ms);
+
+    // Nothing while the events keep coming.
+    for (int i = 0; i < 10; ++i) {
+        debouncer.event(QStringLiteral("a"));
+        QVERIFY(debouncer.isActive());
+        QTest::qWait(10);
+    }
+    QVERIFY(triggeredSpy.isEmpty());
+
+    // Once after the last one, not before its window passed.
+    QElapsedTimer sinceLastEvent;
+    debouncer.event(QStringLiteral("a"));
+    sinceLastEvent.start();
+    QTRY_COMPARE(triggeredSpy.count(), 1);
+    QVERIFY(sinceLastEvent.elapsed() >= 100);
+    QVERIFY(!debouncer.isActive());
+    QTest::qWait(150);
+    QCOMPARE(triggeredSpy.count(), 1);
+
+    // A late event is not dropped, it triggers again.
+    debouncer.event(QStringLiteral("a"));
+    QTRY_COMPARE(triggeredSpy.count(), 2);
+}
+
+void TestAdaptiveDebouncer::testLearnWindow()
+{
+    AdaptiveDebouncer debouncer(20ms, 400ms);
+    QSignalSpy triggeredSpy(&debouncer, &AdaptiveDebouncer::triggered);
+
+    learnWindow(debouncer, triggeredSpy, 100);
+    // The whole burst plus some slack.
+    QVERIFY(debouncer.window(QStringLiteral("a")) >= 150ms);
+    QVERIFY(debouncer.window(QStringLiteral("a")) < 400ms);
+    // Learned per source.
+    QCOMPARE(debouncer.window(QStringLiteral("b")), 20ms);
+
+    // The next burst of the source waits for the learned window.
+    const std::chrono::milliseconds window = debouncer.window(QStringLiteral("a"));
+    QTest::qWait(450);
+    QElapsedTimer sinceEvent;
+    debouncer.event(QStringLiteral("a"));
+    sinceEvent.start();
+    QTRY_COMPARE_WITH_TIMEOUT(triggeredSpy.count(), 3, 2000);
+    QVERIFY(sinceEvent.elapsed() >= window.count());
+}
+
+void TestAdaptiveDebouncer::testMaxWindow()
+{
+    AdaptiveDebouncer debouncer(20ms, 400ms);
+    QSignalSpy triggeredSpy(&debouncer, &AdaptiveDebouncer::triggered);
+
+    learnWindow(debouncer, triggeredSpy, 300);
+    QCOMPARE(debouncer.window(QStringLiteral("a")), 400ms);
+}
+
+void TestAdaptiveDebouncer::testDecay()
+{
+    AdaptiveDebouncer debouncer(20ms, 400ms);
+    QSignalSpy triggeredSpy(&debouncer, &AdaptiveDebouncer::triggered);
+
+    learnWindow(debouncer, triggeredSpy, 200);
+    const std::chrono::milliseconds learned = debouncer.window(QStringLiteral("a"));
+    QVERIFY(learned > 20ms);
+
+    // A single quick event long after the last burst shrinks the window, but only a bit.
+    QTest::qWait(450);
+    debouncer.event(QStringLiteral("a"));
+    QTRY_COMPARE_WITH_TIMEOUT(triggeredSpy.count(), 3, 2000);
+    const std::chrono::milliseconds decayed = debouncer.window(QStringLiteral("a"));
+    QVERIFY(decayed < learned);
+    QVERIFY(decayed > learned / 2);
+}
+
+void TestAdaptiveDebouncer::testSlowestSourceDecides()
+{
+    AdaptiveDebouncer debouncer(20ms, 400ms);
+    QSignalSpy triggeredSpy(&debouncer, &AdaptiveDebouncer::triggered);
+
+    learnWindow(debouncer, triggeredSpy, 100);
+    const std::chrono::milliseconds window = debouncer.window(QStringLiteral("a"));
+    QTest::qWait(450);
+
+    // The quick source alone would trigger after 20ms.
+    QElapsedTimer sinceEvent;
+    debouncer.event(QStringLiteral("a"));
+    sinceEvent.start();
+    debouncer.event(QStringLiteral("b"));
+    QTRY_COMPARE_WITH_TIMEOUT(triggeredSpy.count(), 3, 2000);
+    QVERIFY(sinceEvent.elapsed() >= window.count());
+}
+
+QTEST_MAIN(TestAdaptiveDebouncer)
+
+#include "adaptivedebouncertest.moc"
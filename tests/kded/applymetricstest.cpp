@@ -0,0 +1,161 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../kded/applymetrics.h"
+
+#include <QObject>
+#include <QtTest>
+
+#include <algorithm>
+#include <random>
+
+class TestApplyMetrics : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testCounters();
+    void testBeginEnd();
+    void testPercentiles();
+    void testBuckets();
+    void testWraparound();
+
+private:
+    static QVariantMap stage(const ApplyMetrics &metrics, const QString &name);
+    static void recordMs(ApplyMetrics &metrics, ApplyMetrics::Stage stage, const QVector<qint64> &valuesMs);
+
+    QTemporaryDir m_temporaryDir;
+};
+
+void TestApplyMetrics::initTestCase()
+{
+    qputenv("XDG_DATA_HOME", m_temporaryDir.path().toUtf8());
+    qputenv("KSCREEN_LOGGING", "false");
+}
+
+QVariantMap TestApplyMetrics::stage(const ApplyMetrics &metrics, const QString &name)
+{
+    return metrics.toVariantMap().value(QStringLiteral("latencies")).toMap().value(name).toMap();
+}
+
+void TestApplyMetrics::recordMs(ApplyMetrics &metrics, ApplyMetrics::Stage stage, const QVector<qint64> &valuesMs)
+{
+    for (qint64 ms : valuesMs) {
+        metrics.record(stage, ms * 1000);
+    }
+}
+
+void TestApplyMetrics::testCounters()
+{
+    ApplyMetrics metrics;
+    metrics.count(ApplyMetrics::Counter::Applies);
+    metrics.count(ApplyMetrics::Counter::Applies);
+    metrics.count(ApplyMetrics::Counter::Saves);
+
+    const QVariantMap counters = metrics.toVariantMap().value(QStringLiteral("counters")).toMap();
+    QCOMPARE(counters.value(QStringLiteral("applies")).toULongLong(), 2ull);
+    QCOMPARE(counters.value(QStringLiteral("skippedApplies")).toULongLong(), 0ull);
+    QCOMPARE(counters.value(QStringLiteral("saves")).toULongLong(), 1ull);
+    QVERIFY(counters.contains(QStringLiteral("writes")));
+}
+
+void TestApplyMetrics::testBeginEnd()
+{
+    ApplyMetrics metrics;
+    // Not begun, nothing to record.
+    metrics.end(ApplyMetrics::Stage::Parse);
+    QCOMPARE(stage(metrics, QStringLiteral("parse")).value(QStringLiteral("count")).toULongLong(), 0ull);
+
+    metrics.begin(ApplyMetrics::Stage::Parse);
+    metrics.end(ApplyMetrics::Stage::Parse);
+    metrics.end(ApplyMetrics::Stage::Parse);
+    QCOMPARE(stage(metrics, QStringLiteral("parse")).value(QStringLiteral("count")).toULongLong(), 1ull);
+
+    // Without restart the first begin counts.
+    metrics.begin(ApplyMetrics::Stage::Total, false);
+    QTest::qWait(20);
+    metrics.begin(ApplyMetrics::Stage::Total, false);
+    metrics.end(ApplyMetrics::Stage::Total);
+    QVERIFY(stage(metrics, QStringLiteral("total")).value(QStringLiteral("maxMs")).toDouble() >= 20);
+}
+
+void TestApplyMetrics::testPercentiles()
+{
+    QVector<qint64> valuesMs;
+    for (int i = 1; i <= 100; ++i) {
+        valuesMs << i;
+    }
+    std::shuffle(valuesMs.begin(), valuesMs.end(), std::mt19937(42));
+
+    ApplyMetrics metrics;
+    recordMs(metrics, ApplyMetrics::Stage::Apply, valuesMs);
+    const QVariantMap apply = stage(metrics, QStringLiteral("apply"));
+    QCOMPARE(apply.value(QStringLiteral("count")).toULongLong(), 100ull);
+    QCOMPARE(apply.value(QStringLiteral("sumMs")).toDouble(), 5050.0);
+    QCOMPARE(apply.value(QStringLiteral("maxMs")).toDouble(), 100.0);
+    QCOMPARE(apply.value(QStringLiteral("p50Ms")).toDouble(), 50.0);
+    QCOMPARE(apply.value(QStringLiteral("p95Ms")).toDouble(), 95.0);
+
+    // Other stages are untouched.
+    const QVariantMap parse = stage(metrics, QStringLiteral("parse"));
+    QCOMPARE(parse.value(QStringLiteral("count")).toULongLong(), 0ull);
+    QCOMPARE(parse.value(QStringLiteral("p50Ms")).toDouble(), 0.0);
+}
+
+void TestApplyMetrics::testBuckets()
+{
+    ApplyMetrics metrics;
+    for (qint64 us : {500, 1000, 1500, 3000, 10000, 6000000}) {
+        metrics.record(ApplyMetrics::Stage::Resolve, us);
+    }
+
+    const QVariantMap map = metrics.toVariantMap();
+    const QVariantList bounds = map.value(QStringLiteral("bucketBoundsMs")).toList();
+    const QVariantList buckets = stage(metrics, QStringLiteral("resolve")).value(QStringLiteral("buckets")).toList();
+    // One more for everything above the last bound.
+    QCOMPARE(buckets.size(), bounds.size() + 1);
+    QCOMPARE(bounds.first().toInt(), 1);
+
+    // Bounds are inclusive.
+    QList<int> counts;
+    for (const QVariant &bucket : buckets) {
+        counts << bucket.toInt();
+    }
+    QCOMPARE(counts, QList<int>({2, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+}
+
+void TestApplyMetrics::testWraparound()
+{
+    ApplyMetrics metrics;
+    // Only the most recent 128 samples make the histogram, the totals cover all.
+    recordMs(metrics, ApplyMetrics::Stage::Generate, QVector<qint64>(72, 1000));
+    QVector<qint64> recentMs;
+    for (int i = 0; i < 128; ++i) {
+        recentMs << i;
+    }
+    recordMs(metrics, ApplyMetrics::Stage::Generate, recentMs);
+
+    const QVariantMap generate = stage(metrics, QStringLiteral("generate"));
+    QCOMPARE(generate.value(QStringLiteral("count")).toULongLong(), 200ull);
+    QCOMPARE(generate.value(QStringLiteral("maxMs")).toDouble(), 1000.0);
+    QCOMPARE(generate.value(QStringLiteral("sumMs")).toDouble(), 72 * 1000.0 + 127 * 128 / 2);
+    QCOMPARE(generate.value(QStringLiteral("p50Ms")).toDouble(), 63.0);
+    QCOMPARE(generate.value(QStringLiteral("p95Ms")).toDouble(), 120.0);
+    int total = 0;
+    for (const QVariant &bucket : generate.value(QStringLiteral("buckets")).toList()) {
+        total += bucket.toInt();
+    }
+    QCOMPARE(total, 128);
+
+    // Wrapping again replaces the oldest first.
+    recordMs(metrics, ApplyMetrics::Stage::Generate, QVector<qint64>(64, 500));
+    QCOMPARE(stage(metrics, QStringLiteral("generate")).value(QStringLiteral("p50Ms")).toDouble(), 127.0);
+}
+
+QTEST_MAIN(TestApplyMetrics)
+
+#include "applymetricstest.moc"
@@ -0,0 +1,125 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../kded/applyscheduler.h"
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QtTest>
+
+#include <kscreen/backendmanager_p.h>
+#include <kscreen/config.h>
+#include <kscreen/getconfigoperation.h>
+
+class TestApplyScheduler : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testApply();
+    void testCoalescing();
+    void testCancel();
+    void testCancelWhileIdle();
+
+private:
+    KScreen::ConfigPtr m_config;
+};
+
+void TestApplyScheduler::initTestCase()
+{
+    qRegisterMetaType<KScreen::ConfigPtr>();
+    qputenv("KSCREEN_LOGGING", "false");
+    qputenv("KSCREEN_BACKEND", "Fake");
+    qputenv("KSCREEN_BACKEND_INPROCESS", "1");
+    qputenv("KSCREEN_BACKEND_ARGS", "TEST_DATA=" TEST_DATA "configs/singleOutput.json");
+
+    auto *op = new KScreen::GetConfigOperation;
+    QVERIFY(op->exec());
+    m_config = op->config();
+    QVERIFY(m_config);
+}
+
+void TestApplyScheduler::cleanupTestCase()
+{
+    KScreen::BackendManager::instance()->shutdownBackend();
+}
+
+void TestApplyScheduler::testApply()
+{
+    ApplyScheduler scheduler;
+    QSignalSpy idleSpy(&scheduler, &ApplyScheduler::idle);
+    QVERIFY(!scheduler.isBusy());
+
+    const KScreen::ConfigPtr config = m_config->clone();
+    scheduler.schedule(config);
+    QVERIFY(scheduler.isBusy());
+    QTRY_COMPARE(idleSpy.count(), 1);
+    QCOMPARE(idleSpy.at(0).at(0).value<KScreen::ConfigPtr>(), config);
+    QVERIFY(idleSpy.at(0).at(1).toBool());
+    QVERIFY(!scheduler.isBusy());
+}
+
+void TestApplyScheduler::testCoalescing()
+{
+    ApplyScheduler scheduler;
+    QVector<KScreen::ConfigPtr> idleConfigs;
+    connect(&scheduler, &ApplyScheduler::idle, this, [&scheduler, &idleConfigs](const KScreen::ConfigPtr &config) {
+        // Only once nothing is left to do.
+        QVERIFY(!scheduler.isBusy());
+        idleConfigs << config;
+    });
+
+    // The first one is applied right away, the last one replaces the others while it is.
+    const KScreen::ConfigPtr first = m_config->clone();
+    const KScreen::ConfigPtr last = m_config->clone();
+    scheduler.schedule(first);
+    for (int i = 0; i < 5; ++i) {
+        scheduler.schedule(m_config->clone());
+    }
+    scheduler.schedule(last);
+
+    QTRY_VERIFY(!idleConfigs.isEmpty());
+    QCOMPARE(idleConfigs, QVector<KScreen::ConfigPtr>{last});
+    QTest::qWait(100);
+    QCOMPARE(idleConfigs.size(), 1);
+}
+
+void TestApplyScheduler::testCancel()
+{
+    ApplyScheduler scheduler;
+    QSignalSpy idleSpy(&scheduler, &ApplyScheduler::idle);
+
+    // The pending config is dropped, the one in flight still reports back.
+    const KScreen::ConfigPtr inFlight = m_config->clone();
+    scheduler.schedule(inFlight);
+    scheduler.schedule(m_config->clone());
+    scheduler.cancel();
+    QVERIFY(scheduler.isBusy());
+    QTRY_COMPARE(idleSpy.count(), 1);
+    QCOMPARE(idleSpy.at(0).at(0).value<KScreen::ConfigPtr>(), inFlight);
+    QTest::qWait(100);
+    QCOMPARE(idleSpy.count(), 1);
+    QVERIFY(!scheduler.isBusy());
+}
+
+void TestApplyScheduler::testCancelWhileIdle()
+{
+    ApplyScheduler scheduler;
+    QSignalSpy idleSpy(&scheduler, &ApplyScheduler::idle);
+    scheduler.cancel();
+    QVERIFY(!scheduler.isBusy());
+
+    const KScreen::ConfigPtr config = m_config->clone();
+    scheduler.schedule(config);
+    QTRY_COMPARE(idleSpy.count(), 1);
+    QCOMPARE(idleSpy.at(0).at(0).value<KScreen::ConfigPtr>(), config);
+}
+
+QTEST_MAIN(TestApplyScheduler)
+
+#include "applyschedulertest.moc"
@@ -0,0 +1,206 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../kded/clientconfigurations.h"
+#include "../../kded/config.h"
+#include "../../common/control.h"
+#include "../../common/persistence.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QtTest>
+
+#include <KScreen/Config>
+#include <KScreen/Mode>
+#include <KScreen/Output>
+#include <KScreen/Screen>
+
+namespace KScreen
+{
+namespace ConfigSerializer
+{
+// Exported private symbol in configserializer_p.h in KScreen
+extern QJsonObject serializeConfig(const KScreen::ConfigPtr &config);
+}
+}
+
+class TestClientConfigurations : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testGeneration();
+    void testStaleGenerationRejected();
+    void testOtherOutputsRejected();
+    void testApplyFinished();
+    void testWrittenOnce();
+
+private:
+    KScreen::ConfigPtr createConfig(bool output2Connected) const;
+    QString layout(const KScreen::ConfigPtr &config) const;
+    QString control(const KScreen::ConfigPtr &config, qreal scale) const;
+
+    QTemporaryDir m_temporaryDir;
+};
+
+void TestClientConfigurations::initTestCase()
+{
+    qputenv("XDG_DATA_HOME", m_temporaryDir.path().toUtf8());
+    qputenv("KSCREEN_LOGGING", "false");
+}
+
+KScreen::ConfigPtr TestClientConfigurations::createConfig(bool output2Connected) const
+{
+    KScreen::ScreenPtr screen = KScreen::ScreenPtr::create();
+    screen->setCurrentSize(QSize(1920, 1080));
+    screen->setMaxSize(QSize(32768, 32768));
+    screen->setMinSize(QSize(8, 8));
+
+    KScreen::ModePtr mode = KScreen::ModePtr::create();
+    mode->setId(QStringLiteral("MODE-0"));
+    mode->setName(QStringLiteral("1920x1080"));
+    mode->setSize(QSize(1920, 1080));
+    mode->setRefreshRate(60.0);
+    const KScreen::ModeList modes = {{mode->id(), mode}};
+
+    KScreen::ConfigPtr config = KScreen::ConfigPtr::create();
+    config->setScreen(screen);
+    for (int id : {1, 2}) {
+        KScreen::OutputPtr output = KScreen::OutputPtr::create();
+        output->setId(id);
+        output->setName(QStringLiteral("OUTPUT-%1").arg(id));
+        output->setConnected(id == 1 || output2Connected);
+        output->setEnabled(output->isConnected());
+        output->setModes(modes);
+        output->setCurrentModeId(mode->id());
+        output->setPos(QPoint((id - 1) * 1920, 0));
+        config->addOutput(output);
+    }
+    return config;
+}
+
+QString TestClientConfigurations::layout(const KScreen::ConfigPtr &config) const
+{
+    return QString::fromUtf8(QJsonDocument(KScreen::ConfigSerializer::serializeConfig(config)).toJson(QJsonDocument::Compact));
+}
+
+QString TestClientConfigurations::control(const KScreen::ConfigPtr &config, qreal scale) const
+{
+    ControlConfig control(config);
+    control.setScale(config->outputs().first(), scale);
+    return QString::fromUtf8(QJsonDocument::fromVariant(control.toVariantMap()).toJson(QJsonDocument::Compact));
+}
+
+void TestClientConfigurations::testGeneration()
+{
+    ClientConfigurations configurations;
+    const KScreen::ConfigPtr current = createConfig(false);
+    configurations.switchedTo(current);
+    const quint32 generation = configurations.generation();
+    QVERIFY(generation != 0);
+
+    // Another config for the same outputs, e.g. applied from the OSD, keeps the client's work valid.
+    configurations.switchedTo(createConfig(false));
+    QCOMPARE(configurations.generation(), generation);
+
+    configurations.switchedTo(createConfig(true));
+    QVERIFY(configurations.generation() != generation);
+    QVERIFY(configurations.generation() != 0);
+}
+
+void TestClientConfigurations::testStaleGenerationRejected()
+{
+    ClientConfigurations configurations;
+    const KScreen::ConfigPtr current = createConfig(false);
+    configurations.switchedTo(current);
+    const quint32 generation = configurations.generation();
+
+    QVERIFY(!configurations.take(layout(current), control(current, 1.0), generation + 1, current));
+    QCOMPARE(configurations.generation(), generation);
+
+    const KScreen::ConfigPtr taken = configurations.take(layout(current), control(current, 1.0), generation, current);
+    QVERIFY(taken);
+    QVERIFY(configurations.generation() != generation);
+
+    // A second client working on the same generation has been superseded.
+    QVERIFY(!configurations.take(layout(current), control(current, 1.0), generation, current));
+}
+
+void TestClientConfigurations::testOtherOutputsRejected()
+{
+    ClientConfigurations configurations;
+    const KScreen::ConfigPtr current = createConfig(false);
+    configurations.switchedTo(current);
+    const quint32 generation = configurations.generation();
+
+    const KScreen::ConfigPtr other = createConfig(true);
+    QVERIFY(!configurations.take(layout(other), control(other, 1.0), generation, current));
+    QCOMPARE(configurations.generation(), generation);
+
+    QVERIFY(!configurations.take(QStringLiteral("garbage"), QString(), generation, current));
+    QCOMPARE(configurations.generation(), generation);
+}
+
+void TestClientConfigurations::testApplyFinished()
+{
+    ClientConfigurations configurations;
+    const KScreen::ConfigPtr current = createConfig(false);
+    configurations.switchedTo(current);
+    QVERIFY(!configurations.applyFinished(current, current, true));
+
+    KScreen::ConfigPtr taken = configurations.take(layout(current), control(current, 1.0), configurations.generation(), current);
+    QVERIFY(taken);
+    QVERIFY(configurations.applyFinished(taken, taken, true));
+    // Saved once.
+    QVERIFY(!configurations.applyFinished(taken, taken, true));
+
+    // Failed to apply.
+    taken = configurations.take(layout(current), control(current, 1.0), configurations.generation(), current);
+    QVERIFY(!configurations.applyFinished(taken, taken, false));
+    QVERIFY(!configurations.applyFinished(taken, taken, true));
+
+    // Replaced by another config before it was applied.
+    taken = configurations.take(layout(current), control(current, 1.0), configurations.generation(), current);
+    QVERIFY(!configurations.applyFinished(current, current, true));
+    QVERIFY(!configurations.applyFinished(taken, taken, true));
+
+    // Dropped because the outputs changed.
+    taken = configurations.take(layout(current), control(current, 1.0), configurations.generation(), current);
+    configurations.switchedTo(createConfig(true));
+    QVERIFY(!configurations.applyFinished(taken, taken, true));
+}
+
+void TestClientConfigurations::testWrittenOnce()
+{
+    ClientConfigurations configurations;
+    const KScreen::ConfigPtr current = createConfig(false);
+    configurations.switchedTo(current);
+
+    Persistence *persistence = Persistence::self();
+    const quint64 writesBefore = persistence->writesPerformed();
+    const KScreen::ConfigPtr taken = configurations.take(layout(current), control(current, 2.0), configurations.generation(), current);
+    QVERIFY(taken);
+    const quint64 controlWrites = persistence->writesPerformed() - writesBefore;
+    QVERIFY(controlWrites > 0);
+
+    // The daemon's Config shares the control data that was just written.
+    Config config(taken);
+    QCOMPARE(ControlConfig::forConfig(taken)->getScale(taken->outputs().first()), 2.0);
+    QVERIFY(configurations.applyFinished(taken, config.data(), true));
+    QVERIFY(config.writeFile());
+    const quint64 writes = persistence->writesPerformed();
+    QVERIFY(writes > writesBefore + controlWrites);
+
+    // Saving the same state again, e.g. after the backend reported it, writes nothing.
+    QVERIFY(config.writeFile());
+    QCOMPARE(persistence->writesPerformed(), writes);
+}
+
+QTEST_MAIN(TestClientConfigurations)
+
+#include "clientconfigurationstest.moc"
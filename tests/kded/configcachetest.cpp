@@ -0,0 +1,154 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../kded/config.h"
+#include "../../kded/configcache.h"
+#include "../../common/persistence.h"
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QStringBuilder>
+#include <QtTest>
+
+#include <KScreen/Config>
+#include <KScreen/Mode>
+#include <KScreen/Output>
+#include <KScreen/Screen>
+
+#include <memory>
+
+class TestConfigCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testSaveKeepsEntry();
+    void testSaveKeepsEntryAsynchronous();
+    void testOtherFilesIgnored();
+    void testExternalChange();
+
+private:
+    std::unique_ptr<Config> createConfig() const;
+    void writeExternally(const QString &fileName, const QByteArray &data);
+    // Waits until the watcher reported a change made after everything before.
+    void waitForWatcher();
+
+    QTemporaryDir m_temporaryDir;
+};
+
+void TestConfigCache::initTestCase()
+{
+    qputenv("XDG_DATA_HOME", m_temporaryDir.path().toUtf8());
+    qputenv("KSCREEN_LOGGING", "false");
+}
+
+void TestConfigCache::init()
+{
+    QVERIFY(QDir().mkpath(Config::configsDirPath()));
+    // Watching from now on.
+    ConfigCache::self();
+}
+
+void TestConfigCache::cleanup()
+{
+    ConfigCache::destroy();
+    Persistence::destroy();
+    QDir(Config::configsDirPath()).removeRecursively();
+}
+
+std::unique_ptr<Config> TestConfigCache::createConfig() const
+{
+    KScreen::ScreenPtr screen = KScreen::ScreenPtr::create();
+    screen->setCurrentSize(QSize(1920, 1080));
+    screen->setMaxSize(QSize(32768, 32768));
+    screen->setMinSize(QSize(8, 8));
+
+    KScreen::ModePtr mode = KScreen::ModePtr::create();
+    mode->setId(QStringLiteral("MODE-0"));
+    mode->setSize(QSize(1920, 1080));
+    mode->setRefreshRate(60.0);
+
+    KScreen::OutputPtr output = KScreen::OutputPtr::create();
+    output->setId(1);
+    output->setName(QStringLiteral("OUTPUT-1"));
+    output->setConnected(true);
+    output->setEnabled(true);
+    output->setModes({{mode->id(), mode}});
+    output->setCurrentModeId(mode->id());
+
+    KScreen::ConfigPtr config = KScreen::ConfigPtr::create();
+    config->setScreen(screen);
+    config->addOutput(output);
+    return std::unique_ptr<Config>(new Config(config));
+}
+
+void TestConfigCache::writeExternally(const QString &fileName, const QByteArray &data)
+{
+    QFile file(Config::configsDirPath() % fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(data);
+}
+
+void TestConfigCache::waitForWatcher()
+{
+    QSignalSpy changedSpy(ConfigCache::self(), &ConfigCache::storedConfigsChanged);
+    writeExternally(QStringLiteral("barrier"), QByteArrayLiteral("[]"));
+    QTRY_VERIFY_WITH_TIMEOUT(!changedSpy.isEmpty(), 10000);
+}
+
+void TestConfigCache::testSaveKeepsEntry()
+{
+    auto config = createConfig();
+    QVERIFY(config->writeFile());
+    QVERIFY(config->writeFile());
+
+    // The watcher sees the directory and the file change, neither drops what was just written.
+    waitForWatcher();
+    QVERIFY(ConfigCache::self()->outputs(config->id()).has_value());
+}
+
+void TestConfigCache::testSaveKeepsEntryAsynchronous()
+{
+    Persistence::self()->startWorker();
+    auto config = createConfig();
+    QVERIFY(config->writeFile());
+    Persistence::self()->flush();
+
+    waitForWatcher();
+    QVERIFY(ConfigCache::self()->outputs(config->id()).has_value());
+}
+
+void TestConfigCache::testOtherFilesIgnored()
+{
+    auto config = createConfig();
+    QVERIFY(config->writeFile());
+
+    // Bookkeeping of the daemon and QSaveFile leftovers.
+    writeExternally(QStringLiteral(".usage"), QByteArrayLiteral("{}"));
+    writeExternally(config->id() % QStringLiteral(".aB3dE9"), QByteArrayLiteral("[]"));
+    waitForWatcher();
+    QVERIFY(ConfigCache::self()->outputs(config->id()).has_value());
+}
+
+void TestConfigCache::testExternalChange()
+{
+    auto config = createConfig();
+    QVERIFY(config->writeFile());
+    waitForWatcher();
+    QVERIFY(ConfigCache::self()->outputs(config->id()).has_value());
+
+    QSignalSpy changedSpy(ConfigCache::self(), &ConfigCache::storedConfigsChanged);
+    writeExternally(config->id(), QByteArrayLiteral("[ ]"));
+    QTRY_VERIFY_WITH_TIMEOUT(!changedSpy.isEmpty(), 10000);
+    QVERIFY(!ConfigCache::self()->outputs(config->id()).has_value());
+}
+
+QTEST_MAIN(TestConfigCache)
+
+#include "configcachetest.moc"
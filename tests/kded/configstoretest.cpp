@@ -0,0 +1,164 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../kded/configstore.h"
+#include "../../common/globals.h"
+
+#include <QObject>
+#include <QStringBuilder>
+#include <QtTest>
+
+#include <algorithm>
+
+class TestConfigStore : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testInsertLookup();
+    void testReopen();
+    void testRemove();
+    void testCompaction();
+    void testImport();
+    void testExport();
+
+private:
+    void writeFile(const QString &name, const QByteArray &data);
+
+    QTemporaryDir m_temporaryDir;
+};
+
+void TestConfigStore::initTestCase()
+{
+    qputenv("XDG_DATA_HOME", m_temporaryDir.path().toUtf8());
+    qputenv("KSCREEN_CONFIG_STORE", "indexed");
+    qputenv("KSCREEN_LOGGING", "false");
+    QVERIFY(ConfigStore::isEnabled());
+}
+
+void TestConfigStore::cleanup()
+{
+    ConfigStore::destroy();
+    QDir(Globals::dirPath()).removeRecursively();
+}
+
+void TestConfigStore::writeFile(const QString &name, const QByteArray &data)
+{
+    QVERIFY(QDir().mkpath(Globals::dirPath()));
+    QFile file(Globals::dirPath() % name);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(data);
+}
+
+void TestConfigStore::testInsertLookup()
+{
+    ConfigStore *store = ConfigStore::self();
+    QVERIFY(store);
+    QVERIFY(!store->contains(QStringLiteral("a")));
+    QVERIFY(store->value(QStringLiteral("a")).isNull());
+
+    QVERIFY(store->insert(QStringLiteral("a"), QByteArrayLiteral("first")));
+    QVERIFY(store->insert(QStringLiteral("b"), QByteArrayLiteral("second")));
+    QVERIFY(store->contains(QStringLiteral("a")));
+    QCOMPARE(store->value(QStringLiteral("a")), QByteArrayLiteral("first"));
+    QCOMPARE(store->value(QStringLiteral("b")), QByteArrayLiteral("second"));
+
+    // Unchanged data is not appended again.
+    const qint64 size = QFileInfo(store->filePath()).size();
+    QVERIFY(store->insert(QStringLiteral("a"), QByteArrayLiteral("first")));
+    QCOMPARE(QFileInfo(store->filePath()).size(), size);
+
+    QVERIFY(store->insert(QStringLiteral("a"), QByteArrayLiteral("updated")));
+    QCOMPARE(store->value(QStringLiteral("a")), QByteArrayLiteral("updated"));
+    QStringList keys = store->keys();
+    std::sort(keys.begin(), keys.end());
+    QCOMPARE(keys, QStringList({QStringLiteral("a"), QStringLiteral("b")}));
+}
+
+void TestConfigStore::testReopen()
+{
+    QVERIFY(ConfigStore::self()->insert(QStringLiteral("a"), QByteArrayLiteral("first")));
+    QVERIFY(ConfigStore::self()->insert(QStringLiteral("a"), QByteArrayLiteral("second")));
+    QVERIFY(ConfigStore::self()->insert(QStringLiteral("b"), QByteArray()));
+    ConfigStore::destroy();
+
+    ConfigStore *store = ConfigStore::self();
+    QCOMPARE(store->value(QStringLiteral("a")), QByteArrayLiteral("second"));
+    QVERIFY(store->contains(QStringLiteral("b")));
+    QVERIFY(store->value(QStringLiteral("b")).isEmpty());
+}
+
+void TestConfigStore::testRemove()
+{
+    ConfigStore *store = ConfigStore::self();
+    QVERIFY(store->insert(QStringLiteral("a"), QByteArrayLiteral("first")));
+    QVERIFY(store->remove(QStringLiteral("a")));
+    QVERIFY(!store->contains(QStringLiteral("a")));
+    ConfigStore::destroy();
+
+    // The tombstone survives reopening.
+    QVERIFY(!ConfigStore::self()->contains(QStringLiteral("a")));
+}
+
+void TestConfigStore::testCompaction()
+{
+    ConfigStore *store = ConfigStore::self();
+    QVERIFY(store->insert(QStringLiteral("small"), QByteArrayLiteral("kept")));
+
+    // Each rewrite leaves the previous record behind as garbage, once there is enough of it the
+    // store compacts itself.
+    const QByteArray chunk(40 * 1024, 'x');
+    for (char c : {'a', 'b', 'c'}) {
+        QVERIFY(store->insert(QStringLiteral("large"), QByteArray(chunk).append(c)));
+    }
+    QVERIFY(QFileInfo(store->filePath()).size() < 2 * chunk.size());
+
+    QVERIFY(store->insert(QStringLiteral("large"), QByteArrayLiteral("d")));
+    QVERIFY(store->compact());
+    QVERIFY(QFileInfo(store->filePath()).size() < 1024);
+    ConfigStore::destroy();
+
+    store = ConfigStore::self();
+    QCOMPARE(store->value(QStringLiteral("small")), QByteArrayLiteral("kept"));
+    QCOMPARE(store->value(QStringLiteral("large")), QByteArrayLiteral("d"));
+}
+
+void TestConfigStore::testImport()
+{
+    writeFile(QStringLiteral("hash1"), QByteArrayLiteral("one"));
+    writeFile(QStringLiteral("hash2_lidOpened"), QByteArrayLiteral("two"));
+
+    // Files are imported only when the store is created.
+    ConfigStore *store = ConfigStore::self();
+    QCOMPARE(store->value(QStringLiteral("hash1")), QByteArrayLiteral("one"));
+    QCOMPARE(store->value(QStringLiteral("hash2_lidOpened")), QByteArrayLiteral("two"));
+    QVERIFY(!store->contains(QStringLiteral("configs.db")));
+    ConfigStore::destroy();
+
+    writeFile(QStringLiteral("hash3"), QByteArrayLiteral("three"));
+    QVERIFY(!ConfigStore::self()->contains(QStringLiteral("hash3")));
+}
+
+void TestConfigStore::testExport()
+{
+    ConfigStore *store = ConfigStore::self();
+    QVERIFY(store->insert(QStringLiteral("hash1"), QByteArrayLiteral("one")));
+    QVERIFY(store->insert(QStringLiteral("hash2"), QByteArrayLiteral("two")));
+    QVERIFY(store->remove(QStringLiteral("hash2")));
+
+    QTemporaryDir exportDir;
+    QCOMPARE(store->exportDirectory(exportDir.path()), 1);
+    QFile file(exportDir.filePath(QStringLiteral("hash1")));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), QByteArrayLiteral("one"));
+    QVERIFY(!QFile::exists(exportDir.filePath(QStringLiteral("hash2"))));
+}
+
+QTEST_MAIN(TestConfigStore)
+
+#include "configstoretest.moc"
@@ -5,6 +5,10 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "../../kded/config.h"
+#include "../../kded/configcompactor.h"
+#include "../../kded/configdelta.h"
+#include "../../kded/configpresets.h"
+#include "../../common/fileformat.h"
 #include "../../common/globals.h"
 
 #include <QObject>
@@ -16,6 +20,7 @@
 #include <KScreen/Output>
 #include <KScreen/Screen>
 
+#include <algorithm>
 #include <memory>
 
 class TestConfig : public QObject
@@ -37,6 +42,12 @@ private Q_SLOTS:
     void testIdenticalOutputs();
     void testMoveConfig();
     void testFixedConfig();
+    void testCborFileFormat();
+    void testConfigEvictions();
+    void testNearestConfig();
+    void testConfigPreset();
+    void testConfigDelta();
+    void testSharedControl();
 
 private:
     QTemporaryDir m_temporaryDir;
@@ -403,6 +414,7 @@ void TestConfig::testMoveConfig()
 
     // Make sure we don't write into TEST_DATA
     QStandardPaths::setTestModeEnabled(true);
+    Globals::resetPaths();
     // TODO: this needs setup of the control directory
 
     // Basic assumptions for the remainder of our tests, this is the situation where the lid is opened
@@ -499,6 +511,157 @@ void TestConfig::testFixedConfig()
     fixedCfg.remove();
 }
 
+void TestConfig::testCborFileFormat()
+{
+    QFile file(QStringLiteral(TEST_DATA "serializerdata/twoScreenConfig.json"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray json = file.readAll();
+    QCOMPARE(FileFormat::detect(json), FileFormat::Format::Json);
+
+    const QJsonDocument document = FileFormat::decode(json);
+    QVERIFY(document.isArray());
+
+    const QByteArray cbor = FileFormat::encode(document, FileFormat::Format::Cbor);
+    QCOMPARE(FileFormat::detect(cbor), FileFormat::Format::Cbor);
+    QVERIFY(cbor.size() < json.size());
+    QCOMPARE(FileFormat::decode(cbor), document);
+
+    QVERIFY(FileFormat::decode(QByteArrayLiteral("\xd9\xd9\xf7\xff")).isNull());
+}
+
+void TestConfig::testConfigEvictions()
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    ConfigCompactor::Limits limits;
+    limits.maxCount = 3;
+    limits.maxAgeDays = 30;
+    limits.lidOpenedMaxAgeDays = 2;
+
+    QHash<QString, QDateTime> lastUsed;
+    lastUsed.insert(QStringLiteral("active"), now.addDays(-100));
+    lastUsed.insert(QStringLiteral("active_lidOpened"), now.addDays(-100));
+    lastUsed.insert(QStringLiteral("recent"), now.addDays(-1));
+    lastUsed.insert(QStringLiteral("older"), now.addDays(-5));
+    lastUsed.insert(QStringLiteral("oldest"), now.addDays(-10));
+    lastUsed.insert(QStringLiteral("oldest_lidOpened"), now);
+    lastUsed.insert(QStringLiteral("stale"), now.addDays(-31));
+    lastUsed.insert(QStringLiteral("orphan_lidOpened"), now.addDays(-3));
+    lastUsed.insert(QStringLiteral("new_lidOpened"), now.addDays(-1));
+
+    QStringList evicted = ConfigCompactor::evictions(lastUsed, QStringLiteral("active"), now, limits);
+    evicted.sort();
+    // The active config and its lid config are kept regardless of age, it counts against the limit.
+    QCOMPARE(evicted,
+             QStringList({QStringLiteral("oldest"), QStringLiteral("oldest_lidOpened"), QStringLiteral("orphan_lidOpened"), QStringLiteral("stale")}));
+
+    QVERIFY(ConfigCompactor::evictions(lastUsed, QStringLiteral("active"), now, ConfigCompactor::Limits()).isEmpty());
+}
+
+void TestConfig::testNearestConfig()
+{
+    // Only one of the outputs is known, not close enough.
+    auto configWrapper = createConfig(true, true);
+    KScreen::OutputPtr output1 = configWrapper->data()->output(1);
+    output1->setName(QStringLiteral("OUTPUT-NEW"));
+    QVERIFY(!configWrapper->readNearestFile());
+
+    // Two known outputs and a new one, positioned right of the known ones.
+    configWrapper = createConfig(true, true);
+    KScreen::OutputPtr output3 = configWrapper->data()->output(1)->clone();
+    output3->setId(3);
+    output3->setName(QStringLiteral("OUTPUT-3"));
+    configWrapper->data()->addOutput(output3);
+
+    configWrapper = configWrapper->readNearestFile();
+    QVERIFY(configWrapper);
+    const auto config = configWrapper->data();
+    output1 = config->output(1);
+    const KScreen::OutputPtr output2 = config->output(2);
+    output3 = config->output(3);
+    QVERIFY(output1->isEnabled());
+    QVERIFY(output2->isEnabled());
+    QVERIFY(output3->isEnabled());
+    QVERIFY(!output3->isPrimary());
+    QCOMPARE(output1->pos(), QPoint(0, 0));
+    // Stored right of the first output, without a gap in between.
+    QCOMPARE(output2->pos(), QPoint(std::min(1920, output1->geometry().width()), 0));
+    QCOMPARE(output3->pos(), QPoint(output2->geometry().x() + output2->geometry().width(), 0));
+}
+
+void TestConfig::testConfigPreset()
+{
+    auto configWrapper = createConfig(true, true);
+    QVERIFY(!configWrapper->readPresetFile());
+
+    // Provision the preset under an arbitrary name
+    QTemporaryDir dataDir;
+    const QByteArray dataDirs = qgetenv("XDG_DATA_DIRS");
+    qputenv("XDG_DATA_DIRS", dataDir.path().toUtf8());
+    Globals::resetPaths();
+    QDir(dataDir.path()).mkpath(QStringLiteral("kscreen/") % ConfigPresets::dirName());
+    QVERIFY(QFile::copy(QStringLiteral(TEST_DATA "serializerdata/disabledScreenConfig.json"),
+                        dataDir.filePath(QStringLiteral("kscreen/") % ConfigPresets::dirName() % QStringLiteral("dock"))));
+    ConfigPresets::destroy();
+
+    configWrapper = configWrapper->readPresetFile();
+    QVERIFY(configWrapper);
+    QVERIFY(configWrapper->data()->output(1)->isEnabled());
+    QVERIFY(!configWrapper->data()->output(2)->isEnabled());
+
+    // Only for exactly these outputs
+    configWrapper = createConfig(true, false);
+    QVERIFY(!configWrapper->readPresetFile());
+
+    // Picked up once the preset is gone
+    QVERIFY(QFile::remove(dataDir.filePath(QStringLiteral("kscreen/") % ConfigPresets::dirName() % QStringLiteral("dock"))));
+    configWrapper = createConfig(true, true);
+    QTRY_VERIFY_WITH_TIMEOUT(!configWrapper->readPresetFile(), 10000);
+
+    qputenv("XDG_DATA_DIRS", dataDirs);
+    Globals::resetPaths();
+    ConfigPresets::destroy();
+}
+
+void TestConfig::testConfigDelta()
+{
+    auto configWrapper = createConfig(true, true);
+    configWrapper = configWrapper->readFile(QStringLiteral("twoScreenConfig.json"));
+    QVERIFY(configWrapper);
+    const KScreen::ConfigPtr live = configWrapper->data();
+    KScreen::ConfigPtr desired = live->clone();
+    QVERIFY(ConfigDelta::compute(live, desired).isEmpty());
+
+    desired->output(2)->setPos(QPoint(0, 1080));
+    desired->output(2)->setScale(2.0);
+    auto outputs = ConfigDelta::compute(live, desired).outputs();
+    QCOMPARE(outputs.size(), 1);
+    QCOMPARE(outputs.value(2), ConfigDelta::Change::Position | ConfigDelta::Change::Scale);
+
+    // Only the state change matters for outputs that are disabled
+    desired = live->clone();
+    desired->output(1)->setEnabled(false);
+    desired->output(1)->setRotation(KScreen::Output::Left);
+    outputs = ConfigDelta::compute(live, desired).outputs();
+    QCOMPARE(outputs.value(1), ConfigDelta::Changes(ConfigDelta::Change::Enabled));
+}
+
+void TestConfig::testSharedControl()
+{
+    auto configWrapper1 = createConfig(true, true);
+    auto configWrapper2 = createConfig(true, true);
+    QVERIFY(configWrapper1->data() != configWrapper2->data());
+    QCOMPARE(configWrapper1->m_control, configWrapper2->m_control);
+
+    auto configWrapper3 = createConfig(true, false);
+    QVERIFY(configWrapper3->m_control != configWrapper1->m_control);
+
+    // Replication sources are looked up in the config asking for them.
+    const auto output1 = configWrapper2->data()->output(1);
+    const auto output2 = configWrapper2->data()->output(2);
+    configWrapper1->m_control->setReplicationSource(output2, output1);
+    QCOMPARE(configWrapper1->m_control->getReplicationSource(configWrapper2->data(), output2), output1);
+}
+
 QTEST_MAIN(TestConfig)
 
 #include "configtest.moc"
@@ -0,0 +1,163 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../common/controlwatcher.h"
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QStringBuilder>
+#include <QtTest>
+
+class TestControlWatcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testShared();
+    void testCompression();
+    void testUnchangedContent();
+    void testOwnWrite();
+    void testRemoved();
+
+private:
+    void writeFile(const QString &fileName, const QByteArray &data);
+    // Changes an unrelated registered file and waits for it, all earlier events are processed by
+    // then and must not have reported anything else.
+    void verifyNothingChanged(QSignalSpy &spy);
+
+    QTemporaryDir *m_temporaryDir = nullptr;
+    QString m_dirPath;
+};
+
+void TestControlWatcher::init()
+{
+    m_temporaryDir = new QTemporaryDir;
+    m_dirPath = m_temporaryDir->path() % QLatin1Char('/');
+    writeFile(QStringLiteral("a"), QByteArrayLiteral("a1"));
+    writeFile(QStringLiteral("barrier"), QByteArrayLiteral("0"));
+}
+
+void TestControlWatcher::cleanup()
+{
+    delete m_temporaryDir;
+    m_temporaryDir = nullptr;
+}
+
+void TestControlWatcher::writeFile(const QString &fileName, const QByteArray &data)
+{
+    QFile file(m_dirPath % fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(data);
+}
+
+void TestControlWatcher::verifyNothingChanged(QSignalSpy &spy)
+{
+    const QByteArray data = QByteArray::number(QDateTime::currentMSecsSinceEpoch());
+    writeFile(QStringLiteral("barrier"), data);
+
+    QStringList fileNames;
+    const auto reachedBarrier = [&spy, &fileNames]() {
+        fileNames.clear();
+        for (const auto &arguments : qAsConst(spy)) {
+            fileNames << arguments.at(0).toStringList();
+        }
+        return fileNames.contains(QStringLiteral("barrier"));
+    };
+    QTRY_VERIFY_WITH_TIMEOUT(reachedBarrier(), 10000);
+    spy.clear();
+    fileNames.removeAll(QStringLiteral("barrier"));
+    QCOMPARE(fileNames, QStringList());
+}
+
+void TestControlWatcher::testShared()
+{
+    QSharedPointer<ControlWatcher> watcher = ControlWatcher::forDirectory(m_dirPath);
+    QCOMPARE(ControlWatcher::forDirectory(m_dirPath), watcher);
+
+    QTemporaryDir otherDir;
+    QVERIFY(ControlWatcher::forDirectory(otherDir.path() % QLatin1Char('/')) != watcher);
+
+    watcher->addFile(QStringLiteral("a"));
+    QCOMPARE(watcher->data(QStringLiteral("a")), QByteArrayLiteral("a1"));
+
+    // Once released a fresh watcher is handed out.
+    const QWeakPointer<ControlWatcher> released = watcher;
+    watcher.reset();
+    QVERIFY(released.isNull());
+    watcher = ControlWatcher::forDirectory(m_dirPath);
+    QVERIFY(watcher->data(QStringLiteral("a")).isEmpty());
+}
+
+void TestControlWatcher::testCompression()
+{
+    QSharedPointer<ControlWatcher> watcher = ControlWatcher::forDirectory(m_dirPath);
+    watcher->addFile(QStringLiteral("a"));
+    watcher->addFile(QStringLiteral("barrier"));
+    QSignalSpy changedSpy(watcher.data(), &ControlWatcher::filesChanged);
+
+    // Written in quick succession, reported once with the final content.
+    for (int i = 2; i <= 5; ++i) {
+        writeFile(QStringLiteral("a"), QByteArrayLiteral("a") + QByteArray::number(i));
+    }
+    QTRY_VERIFY_WITH_TIMEOUT(!changedSpy.isEmpty(), 10000);
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.at(0).at(0).toStringList(), QStringList{QStringLiteral("a")});
+    QCOMPARE(watcher->data(QStringLiteral("a")), QByteArrayLiteral("a5"));
+
+    changedSpy.clear();
+    verifyNothingChanged(changedSpy);
+}
+
+void TestControlWatcher::testUnchangedContent()
+{
+    QSharedPointer<ControlWatcher> watcher = ControlWatcher::forDirectory(m_dirPath);
+    watcher->addFile(QStringLiteral("a"));
+    watcher->addFile(QStringLiteral("barrier"));
+    QSignalSpy changedSpy(watcher.data(), &ControlWatcher::filesChanged);
+
+    writeFile(QStringLiteral("a"), QByteArrayLiteral("a1"));
+    verifyNothingChanged(changedSpy);
+
+    // Files nobody registered are ignored.
+    writeFile(QStringLiteral("unknown"), QByteArrayLiteral("data"));
+    verifyNothingChanged(changedSpy);
+}
+
+void TestControlWatcher::testOwnWrite()
+{
+    QSharedPointer<ControlWatcher> watcher = ControlWatcher::forDirectory(m_dirPath);
+    watcher->addFile(QStringLiteral("a"));
+    watcher->addFile(QStringLiteral("barrier"));
+    QSignalSpy changedSpy(watcher.data(), &ControlWatcher::filesChanged);
+
+    ControlWatcher::fileWritten(m_dirPath % QStringLiteral("a"), QByteArrayLiteral("own"));
+    QCOMPARE(watcher->data(QStringLiteral("a")), QByteArrayLiteral("own"));
+    writeFile(QStringLiteral("a"), QByteArrayLiteral("own"));
+    verifyNothingChanged(changedSpy);
+
+    // Someone else writing afterwards is reported again.
+    writeFile(QStringLiteral("a"), QByteArrayLiteral("other"));
+    QTRY_VERIFY_WITH_TIMEOUT(!changedSpy.isEmpty(), 10000);
+    QCOMPARE(changedSpy.at(0).at(0).toStringList(), QStringList{QStringLiteral("a")});
+}
+
+void TestControlWatcher::testRemoved()
+{
+    QSharedPointer<ControlWatcher> watcher = ControlWatcher::forDirectory(m_dirPath);
+    watcher->addFile(QStringLiteral("a"));
+    QSignalSpy changedSpy(watcher.data(), &ControlWatcher::filesChanged);
+
+    QVERIFY(QFile::remove(m_dirPath % QStringLiteral("a")));
+    QTRY_VERIFY_WITH_TIMEOUT(!changedSpy.isEmpty(), 10000);
+    QCOMPARE(changedSpy.at(0).at(0).toStringList(), QStringList{QStringLiteral("a")});
+    QVERIFY(watcher->data(QStringLiteral("a")).isEmpty());
+}
+
+QTEST_MAIN(TestControlWatcher)
+
+#include "controlwatchertest.moc"
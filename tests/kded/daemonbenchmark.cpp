@@ -0,0 +1,97 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../common/orientation_sensor.h"
+#include "../../kded/daemon.h"
+#include "../../kded/osdmanager.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QtTest>
+
+#include <unistd.h>
+
+/**
+ * Reports the time and resident memory it takes the daemon to start up until its config is
+ * ready, with the orientation sensor and the OSD's QML types created on first use as the daemon
+ * does, and created eagerly at startup as it did before.
+ *
+ * Run each benchmark in its own process, e.g. "daemonbenchmark benchmarkLazyInit", as shared
+ * libraries loaded for one would otherwise be accounted to the other.
+ */
+class DaemonBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkLazyInit();
+    void benchmarkEagerInit();
+
+private:
+    static qint64 residentKiB();
+    void report(const char *name, bool eager);
+
+    QTemporaryDir m_temporaryDir;
+};
+
+void DaemonBenchmark::initTestCase()
+{
+    qputenv("XDG_DATA_HOME", m_temporaryDir.path().toUtf8());
+    qputenv("KSCREEN_LOGGING", "false");
+    qputenv("KSCREEN_BACKEND", "Fake");
+    qputenv("KSCREEN_BACKEND_INPROCESS", "1");
+    qputenv("KSCREEN_BACKEND_ARGS", "TEST_DATA=" TEST_DATA "configs/laptopAndExternal.json");
+}
+
+qint64 DaemonBenchmark::residentKiB()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.value(1).toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+void DaemonBenchmark::report(const char *name, bool eager)
+{
+    const qint64 residentBefore = residentKiB();
+    QElapsedTimer timer;
+    timer.start();
+
+    auto *daemon = new KScreenDaemon(this, {});
+    if (eager) {
+        // What the daemon created in its constructor before.
+        daemon->m_orientationSensor = new OrientationSensor(daemon);
+        daemon->m_orientationSensor->setEnabled(true);
+        KScreen::OsdManager::registerQmlTypes();
+    }
+    while (!daemon->m_monitoredConfig && timer.elapsed() < 10000) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 100);
+    }
+    const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+    const qint64 residentAfter = residentKiB();
+    QVERIFY(daemon->m_monitoredConfig);
+
+    qInfo("%s: ready in %lld us, %+lld KiB resident", name, elapsedUs, residentAfter - residentBefore);
+    delete daemon;
+}
+
+void DaemonBenchmark::benchmarkLazyInit()
+{
+    report("Lazy", false);
+}
+
+void DaemonBenchmark::benchmarkEagerInit()
+{
+    report("Eager", true);
+}
+
+QTEST_MAIN(DaemonBenchmark)
+
+#include "daemonbenchmark.moc"
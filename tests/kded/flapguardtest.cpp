@@ -0,0 +1,120 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../kded/flapguard.h"
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QtTest>
+
+class TestFlapGuard : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testOccasionalToggles();
+    void testFlapping();
+    void testEpisodesCounted();
+    void testPerOutput();
+    void testBackoffStartsOver();
+};
+
+void TestFlapGuard::initTestCase()
+{
+    qputenv("KSCREEN_LOGGING", "false");
+}
+
+void TestFlapGuard::testOccasionalToggles()
+{
+    FlapGuard guard;
+    QSignalSpy settledSpy(&guard, &FlapGuard::settled);
+
+    // Plugging and unplugging is handled right away and is no flap.
+    QVERIFY(guard.toggled(QStringLiteral("DP-1")));
+    QVERIFY(guard.toggled(QStringLiteral("DP-1")));
+    QCOMPARE(guard.flapCounts().value(QStringLiteral("DP-1")).toUInt(), 0u);
+    QVERIFY(settledSpy.isEmpty());
+}
+
+void TestFlapGuard::testFlapping()
+{
+    FlapGuard guard;
+    QSignalSpy settledSpy(&guard, &FlapGuard::settled);
+
+    QVERIFY(guard.toggled(QStringLiteral("DP-1")));
+    QVERIFY(guard.toggled(QStringLiteral("DP-1")));
+    QVERIFY(guard.toggled(QStringLiteral("DP-1")));
+    QVERIFY(!guard.toggled(QStringLiteral("DP-1")));
+    QVERIFY(!guard.toggled(QStringLiteral("DP-1")));
+
+    // Settles once, after the output stayed stable for the backoff.
+    QTRY_COMPARE_WITH_TIMEOUT(settledSpy.count(), 1, 5000);
+    QCOMPARE(settledSpy.at(0).at(0).toString(), QStringLiteral("DP-1"));
+    QTest::qWait(100);
+    QCOMPARE(settledSpy.count(), 1);
+
+    // Handled right away again afterwards.
+    QVERIFY(guard.toggled(QStringLiteral("DP-1")));
+}
+
+void TestFlapGuard::testEpisodesCounted()
+{
+    FlapGuard guard;
+    QSignalSpy settledSpy(&guard, &FlapGuard::settled);
+
+    // Toggles while held back belong to the same episode.
+    for (int i = 0; i < 10; ++i) {
+        guard.toggled(QStringLiteral("DP-1"));
+    }
+    QCOMPARE(guard.flapCounts().value(QStringLiteral("DP-1")).toUInt(), 1u);
+    QTRY_COMPARE_WITH_TIMEOUT(settledSpy.count(), 1, 5000);
+
+    for (int i = 0; i < 4; ++i) {
+        guard.toggled(QStringLiteral("DP-1"));
+    }
+    QCOMPARE(guard.flapCounts().value(QStringLiteral("DP-1")).toUInt(), 2u);
+}
+
+void TestFlapGuard::testPerOutput()
+{
+    FlapGuard guard;
+    for (int i = 0; i < 4; ++i) {
+        guard.toggled(QStringLiteral("DP-1"));
+    }
+    QVERIFY(guard.toggled(QStringLiteral("HDMI-1")));
+    QCOMPARE(guard.flapCounts().value(QStringLiteral("DP-1")).toUInt(), 1u);
+    QCOMPARE(guard.flapCounts().value(QStringLiteral("HDMI-1")).toUInt(), 0u);
+}
+
+void TestFlapGuard::testBackoffStartsOver()
+{
+    FlapGuard guard;
+    guard.m_stablePeriodMs = 3000;
+    QSignalSpy settledSpy(&guard, &FlapGuard::settled);
+    const QString name = QStringLiteral("DP-1");
+    const auto flap = [&guard, &name]() {
+        for (int i = 0; i < 4; ++i) {
+            guard.toggled(name);
+        }
+        return guard.m_outputs.value(name).timer->interval();
+    };
+
+    QCOMPARE(flap(), 1000);
+    QTRY_COMPARE_WITH_TIMEOUT(settledSpy.count(), 1, 5000);
+
+    // Flapping again soon after backs off longer.
+    QCOMPARE(flap(), 2000);
+    QTRY_COMPARE_WITH_TIMEOUT(settledSpy.count(), 2, 5000);
+
+    // Not after the output stayed stable for a while.
+    QTest::qWait(1500);
+    QCOMPARE(flap(), 1000);
+}
+
+QTEST_MAIN(TestFlapGuard)
+
+#include "flapguardtest.moc"
@@ -0,0 +1,113 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../common/flightrecorder.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QtTest>
+
+#include <thread>
+
+class TestFlightRecorder : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testInstant();
+    void testSpan();
+    void testThreads();
+    void testWraparound();
+
+private:
+    // Events of the test category, oldest first
+    static QList<QJsonObject> events();
+};
+
+QList<QJsonObject> TestFlightRecorder::events()
+{
+    QList<QJsonObject> events;
+    const QJsonArray traceEvents = QJsonDocument::fromJson(FlightRecorder::toTraceJson()).object().value(QStringLiteral("traceEvents")).toArray();
+    for (const QJsonValue &value : traceEvents) {
+        const QJsonObject event = value.toObject();
+        if (event.value(QStringLiteral("cat")).toString() == QLatin1String("test")) {
+            events << event;
+        }
+    }
+    return events;
+}
+
+void TestFlightRecorder::testInstant()
+{
+    FlightRecorder::instant("test", "instant1");
+    FlightRecorder::instant("test", "instant2");
+
+    const QList<QJsonObject> recorded = events();
+    QVERIFY(recorded.size() >= 2);
+    const QJsonObject first = recorded.at(recorded.size() - 2);
+    const QJsonObject second = recorded.last();
+    QCOMPARE(first.value(QStringLiteral("name")).toString(), QStringLiteral("instant1"));
+    QCOMPARE(second.value(QStringLiteral("name")).toString(), QStringLiteral("instant2"));
+    QCOMPARE(second.value(QStringLiteral("ph")).toString(), QStringLiteral("i"));
+    QVERIFY(!second.contains(QStringLiteral("dur")));
+    QCOMPARE(qint64(second.value(QStringLiteral("pid")).toDouble()), QCoreApplication::applicationPid());
+    QVERIFY(second.value(QStringLiteral("ts")).toDouble() >= first.value(QStringLiteral("ts")).toDouble());
+}
+
+void TestFlightRecorder::testSpan()
+{
+    const qint64 beforeNs = FlightRecorder::now();
+    {
+        KSCREEN_TRACE_SPAN("test", "span");
+        QTest::qSleep(10);
+    }
+    FlightRecorder::instant("test", "afterSpan");
+
+    const QList<QJsonObject> recorded = events();
+    QVERIFY(recorded.size() >= 2);
+    const QJsonObject span = recorded.at(recorded.size() - 2);
+    QCOMPARE(span.value(QStringLiteral("name")).toString(), QStringLiteral("span"));
+    QCOMPARE(span.value(QStringLiteral("ph")).toString(), QStringLiteral("X"));
+    // In microseconds
+    QVERIFY(span.value(QStringLiteral("ts")).toDouble() >= beforeNs / 1000.0);
+    QVERIFY(span.value(QStringLiteral("dur")).toDouble() >= 10000);
+    const QJsonObject after = recorded.last();
+    QVERIFY(after.value(QStringLiteral("ts")).toDouble() >= span.value(QStringLiteral("ts")).toDouble() + span.value(QStringLiteral("dur")).toDouble());
+}
+
+void TestFlightRecorder::testThreads()
+{
+    FlightRecorder::instant("test", "mainThread");
+    std::thread([]() {
+        FlightRecorder::instant("test", "otherThread");
+    }).join();
+
+    const QList<QJsonObject> recorded = events();
+    QVERIFY(recorded.size() >= 2);
+    QCOMPARE(recorded.last().value(QStringLiteral("name")).toString(), QStringLiteral("otherThread"));
+    QVERIFY(recorded.last().value(QStringLiteral("tid")) != recorded.at(recorded.size() - 2).value(QStringLiteral("tid")));
+}
+
+void TestFlightRecorder::testWraparound()
+{
+    FlightRecorder::instant("test", "oldest");
+    for (int i = 0; i < 4096; ++i) {
+        FlightRecorder::instant("fill", "fill");
+    }
+    FlightRecorder::instant("test", "newest");
+
+    // The oldest entries are overwritten, the buffer keeps a fixed number of entries.
+    const QList<QJsonObject> recorded = events();
+    QCOMPARE(recorded.size(), 1);
+    QCOMPARE(recorded.first().value(QStringLiteral("name")).toString(), QStringLiteral("newest"));
+    const QJsonArray traceEvents = QJsonDocument::fromJson(FlightRecorder::toTraceJson()).object().value(QStringLiteral("traceEvents")).toArray();
+    QVERIFY(traceEvents.size() < 4096);
+}
+
+QTEST_MAIN(TestFlightRecorder)
+
+#include "flightrecordertest.moc"
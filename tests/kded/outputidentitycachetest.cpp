@@ -0,0 +1,100 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../kded/outputidentitycache.h"
+
+#include <QObject>
+#include <QtTest>
+
+#include <kscreen/backendmanager_p.h>
+#include <kscreen/config.h>
+#include <kscreen/edid.h>
+#include <kscreen/getconfigoperation.h>
+#include <kscreen/output.h>
+
+class TestOutputIdentityCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+
+    void testIdentities();
+    void testSameMonitor();
+    void testOtherMonitor();
+
+private:
+    KScreen::ConfigPtr m_config;
+};
+
+void TestOutputIdentityCache::initTestCase()
+{
+    qputenv("KSCREEN_LOGGING", "false");
+    qputenv("KSCREEN_BACKEND", "Fake");
+    qputenv("KSCREEN_BACKEND_INPROCESS", "1");
+    qputenv("KSCREEN_BACKEND_ARGS", "TEST_DATA=" TEST_DATA "configs/laptopAndExternal.json");
+
+    auto *op = new KScreen::GetConfigOperation;
+    QVERIFY(op->exec());
+    m_config = op->config();
+    QVERIFY(m_config);
+    QVERIFY(m_config->output(1)->edid() && m_config->output(1)->edid()->isValid());
+    QVERIFY(m_config->output(2)->edid() && m_config->output(2)->edid()->isValid());
+}
+
+void TestOutputIdentityCache::cleanupTestCase()
+{
+    KScreen::BackendManager::instance()->shutdownBackend();
+}
+
+void TestOutputIdentityCache::cleanup()
+{
+    OutputIdentityCache::destroy();
+}
+
+void TestOutputIdentityCache::testIdentities()
+{
+    auto *identities = OutputIdentityCache::self();
+    for (const KScreen::OutputPtr &output : m_config->outputs()) {
+        QCOMPARE(identities->hash(output), output->hash());
+        QCOMPARE(identities->hashMd5(output), output->hashMd5());
+    }
+    QVERIFY(identities->hash(m_config->output(1)) != identities->hash(m_config->output(2)));
+}
+
+void TestOutputIdentityCache::testSameMonitor()
+{
+    auto *identities = OutputIdentityCache::self();
+    const QString hash = identities->hash(m_config->output(2));
+
+    // Same monitor in a config fetched later, for example after resume.
+    const KScreen::ConfigPtr later = m_config->clone();
+    QCOMPARE(identities->hash(later->output(2)), hash);
+    QCOMPARE(identities->hashMd5(later->output(2)), m_config->output(2)->hashMd5());
+}
+
+void TestOutputIdentityCache::testOtherMonitor()
+{
+    auto *identities = OutputIdentityCache::self();
+    const QString hash = identities->hash(m_config->output(2));
+    const QString hashMd5 = identities->hashMd5(m_config->output(2));
+
+    // Another monitor on the same connector, the EDID tells.
+    const KScreen::ConfigPtr replugged = m_config->clone();
+    const KScreen::OutputPtr output = replugged->output(2);
+    output->setEdid(m_config->output(1)->edid()->rawData());
+    QCOMPARE(identities->hash(output), output->hash());
+    QCOMPARE(identities->hashMd5(output), output->hashMd5());
+    QVERIFY(identities->hashMd5(output) != hashMd5);
+
+    // And back.
+    QCOMPARE(identities->hash(m_config->output(2)), hash);
+}
+
+QTEST_MAIN(TestOutputIdentityCache)
+
+#include "outputidentitycachetest.moc"
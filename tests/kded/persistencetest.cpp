@@ -0,0 +1,285 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../kded/config.h"
+#include "../../kded/configcache.h"
+#include "../../common/persistence.h"
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QStringBuilder>
+#include <QtTest>
+
+class TestPersistence : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testSynchronousWrite();
+    void testSkipUnchangedContent();
+    void testSkipContentFoundOnDisk();
+    void testSkipRemoveOfMissingFile();
+    void testCoalescing();
+    void testFlush();
+    void testRemoveAfterWrite();
+    void testWriteAfterRemove();
+    void testPending();
+    void testReadEntryInvalidatedAsynchronous();
+
+private:
+    QString filePath(const QString &fileName) const;
+    QByteArray readFile(const QString &filePath) const;
+
+    QTemporaryDir m_temporaryDir;
+};
+
+void TestPersistence::initTestCase()
+{
+    qputenv("XDG_DATA_HOME", m_temporaryDir.path().toUtf8());
+    qputenv("KSCREEN_LOGGING", "false");
+}
+
+void TestPersistence::cleanup()
+{
+    ConfigCache::destroy();
+    Persistence::destroy();
+    QDir(m_temporaryDir.filePath(QStringLiteral("files"))).removeRecursively();
+    QDir(Config::configsDirPath()).removeRecursively();
+}
+
+QString TestPersistence::filePath(const QString &fileName) const
+{
+    return m_temporaryDir.filePath(QStringLiteral("files/") % fileName);
+}
+
+QByteArray TestPersistence::readFile(const QString &filePath) const
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+void TestPersistence::testSynchronousWrite()
+{
+    Persistence *persistence = Persistence::self();
+    QVERIFY(!persistence->isAsynchronous());
+    QSignalSpy writtenSpy(persistence, &Persistence::written);
+
+    // Without worker the file is on disk once write() returns.
+    const QString path = filePath(QStringLiteral("a"));
+    QVERIFY(persistence->write(path, QByteArrayLiteral("data")));
+    QCOMPARE(readFile(path), QByteArrayLiteral("data"));
+    QCOMPARE(writtenSpy.count(), 1);
+    QCOMPARE(writtenSpy.at(0).at(0).toString(), path);
+    QCOMPARE(writtenSpy.at(0).at(1).toBool(), true);
+
+    QVERIFY(persistence->remove(path));
+    QVERIFY(!QFile::exists(path));
+    QCOMPARE(writtenSpy.count(), 2);
+}
+
+void TestPersistence::testSkipUnchangedContent()
+{
+    Persistence *persistence = Persistence::self();
+    const QString path = filePath(QStringLiteral("a"));
+    QVERIFY(persistence->write(path, QByteArrayLiteral("data")));
+    QCOMPARE(persistence->writesPerformed(), quint64(1));
+    QCOMPARE(persistence->writesSkipped(), quint64(0));
+    QCOMPARE(persistence->bytesWritten(), quint64(4));
+    const QDateTime lastModified = QFileInfo(path).lastModified();
+
+    // Known content, the file is neither read back nor written.
+    QVERIFY(persistence->write(path, QByteArrayLiteral("data")));
+    QCOMPARE(persistence->writesPerformed(), quint64(1));
+    QCOMPARE(persistence->writesSkipped(), quint64(1));
+    QCOMPARE(persistence->bytesWritten(), quint64(4));
+    QCOMPARE(QFileInfo(path).lastModified(), lastModified);
+
+    QVERIFY(persistence->write(path, QByteArrayLiteral("other")));
+    QCOMPARE(persistence->writesPerformed(), quint64(2));
+    QCOMPARE(persistence->writesSkipped(), quint64(1));
+    QCOMPARE(persistence->bytesWritten(), quint64(9));
+    QCOMPARE(readFile(path), QByteArrayLiteral("other"));
+}
+
+void TestPersistence::testSkipContentFoundOnDisk()
+{
+    Persistence *persistence = Persistence::self();
+    const QString path = filePath(QStringLiteral("a"));
+    const auto writeExternally = [&path](const QByteArray &data, const QDateTime &lastModified) {
+        QVERIFY(QDir().mkpath(QFileInfo(path).path()));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(data);
+        QVERIFY(file.flush());
+        QVERIFY(file.setFileTime(lastModified, QFileDevice::FileModificationTime));
+    };
+    const QDateTime now = QDateTime::currentDateTime();
+
+    // Unknown file with the same content, read back once and skipped.
+    writeExternally(QByteArrayLiteral("data"), now.addSecs(-60));
+    QVERIFY(persistence->write(path, QByteArrayLiteral("data")));
+    QCOMPARE(persistence->writesPerformed(), quint64(0));
+    QCOMPARE(persistence->writesSkipped(), quint64(1));
+
+    // Changed by someone else in between, same size but different content.
+    writeExternally(QByteArrayLiteral("dat2"), now.addSecs(-30));
+    QVERIFY(persistence->write(path, QByteArrayLiteral("data")));
+    QCOMPARE(persistence->writesPerformed(), quint64(1));
+    QCOMPARE(persistence->writesSkipped(), quint64(1));
+    QCOMPARE(readFile(path), QByteArrayLiteral("data"));
+}
+
+void TestPersistence::testSkipRemoveOfMissingFile()
+{
+    Persistence *persistence = Persistence::self();
+    const QString path = filePath(QStringLiteral("a"));
+    QVERIFY(persistence->remove(path));
+    QCOMPARE(persistence->writesPerformed(), quint64(0));
+    QCOMPARE(persistence->writesSkipped(), quint64(1));
+
+    QVERIFY(persistence->write(path, QByteArrayLiteral("data")));
+    QVERIFY(persistence->remove(path));
+    QCOMPARE(persistence->writesPerformed(), quint64(2));
+    QCOMPARE(persistence->writesSkipped(), quint64(1));
+    QVERIFY(!QFile::exists(path));
+}
+
+void TestPersistence::testCoalescing()
+{
+    Persistence *persistence = Persistence::self();
+    persistence->startWorker();
+    QVERIFY(persistence->isAsynchronous());
+    QSignalSpy writtenSpy(persistence, &Persistence::written);
+
+    // Queuing is a lot faster than writing, so most of these replace a still queued write.
+    const QString path = filePath(QStringLiteral("a"));
+    const int count = 1000;
+    for (int i = 0; i < count; ++i) {
+        QVERIFY(persistence->write(path, QByteArray::number(i)));
+    }
+    persistence->flush();
+    QCOMPARE(readFile(path), QByteArray::number(count - 1));
+    QVERIFY(persistence->writesPerformed() < quint64(count));
+
+    QTRY_VERIFY(!writtenSpy.isEmpty());
+    QVERIFY(writtenSpy.count() < count);
+    QCOMPARE(writtenSpy.last().at(0).toString(), path);
+}
+
+void TestPersistence::testFlush()
+{
+    Persistence *persistence = Persistence::self();
+    persistence->startWorker();
+    QSignalSpy writtenSpy(persistence, &Persistence::written);
+
+    const QString pathA = filePath(QStringLiteral("a"));
+    const QString pathB = filePath(QStringLiteral("b"));
+    QVERIFY(persistence->write(pathA, QByteArrayLiteral("a1")));
+    QVERIFY(persistence->write(pathB, QByteArrayLiteral("b1")));
+    QVERIFY(persistence->write(pathA, QByteArrayLiteral("a2")));
+
+    persistence->flush();
+    QCOMPARE(readFile(pathA), QByteArrayLiteral("a2"));
+    QCOMPARE(readFile(pathB), QByteArrayLiteral("b1"));
+
+    // Completion is reported in our thread, in the order the paths were first queued.
+    QVERIFY(writtenSpy.isEmpty());
+    QTRY_VERIFY(writtenSpy.count() >= 2);
+    QCOMPARE(writtenSpy.at(0).at(0).toString(), pathA);
+    for (const auto &arguments : qAsConst(writtenSpy)) {
+        QVERIFY(arguments.at(1).toBool());
+    }
+}
+
+void TestPersistence::testRemoveAfterWrite()
+{
+    Persistence *persistence = Persistence::self();
+    persistence->startWorker();
+
+    const QString path = filePath(QStringLiteral("a"));
+    QVERIFY(persistence->write(path, QByteArrayLiteral("data")));
+    QVERIFY(persistence->remove(path));
+    persistence->flush();
+    QVERIFY(!QFile::exists(path));
+}
+
+void TestPersistence::testWriteAfterRemove()
+{
+    Persistence *persistence = Persistence::self();
+    const QString path = filePath(QStringLiteral("a"));
+    QVERIFY(persistence->write(path, QByteArrayLiteral("old")));
+
+    persistence->startWorker();
+    QVERIFY(persistence->remove(path));
+    QVERIFY(persistence->write(path, QByteArrayLiteral("new")));
+    persistence->flush();
+    QCOMPARE(readFile(path), QByteArrayLiteral("new"));
+}
+
+void TestPersistence::testPending()
+{
+    Persistence *persistence = Persistence::self();
+    const QString path = filePath(QStringLiteral("a"));
+    QVERIFY(persistence->write(path, QByteArrayLiteral("sync")));
+    QVERIFY(!persistence->isPending(path));
+
+    persistence->startWorker();
+    QSignalSpy writtenSpy(persistence, &Persistence::written);
+    QVERIFY(persistence->write(path, QByteArrayLiteral("1")));
+    QVERIFY(persistence->isPending(path));
+    persistence->flush();
+    // Until the completion was delivered to our thread.
+    QVERIFY(persistence->isPending(path));
+    QTRY_COMPARE(writtenSpy.count(), 1);
+    QVERIFY(!persistence->isPending(path));
+
+    // Completion of an earlier write does not end a later one.
+    QVERIFY(persistence->write(path, QByteArrayLiteral("2")));
+    persistence->flush();
+    QVERIFY(persistence->write(path, QByteArrayLiteral("3")));
+    QTRY_COMPARE(writtenSpy.count(), 2);
+    QVERIFY(persistence->isPending(path));
+    persistence->flush();
+    QTRY_COMPARE(writtenSpy.count(), 3);
+    QVERIFY(!persistence->isPending(path));
+}
+
+void TestPersistence::testReadEntryInvalidatedAsynchronous()
+{
+    // Entries read from disk must be dropped on external changes also with the worker running,
+    // only entries of our own queued writes ignore change notifications until written.
+    Persistence::self()->startWorker();
+    QVERIFY(QDir().mkpath(Config::configsDirPath()));
+    const QString fileName = QStringLiteral("readConfig");
+    const QString path = Config::configsDirPath() % fileName;
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QByteArrayLiteral("[]"));
+    }
+
+    ConfigCache *cache = ConfigCache::self();
+    cache->insert(fileName, QVector<OutputRecord>());
+    QVERIFY(cache->outputs(fileName).has_value());
+
+    QSignalSpy changedSpy(cache, &ConfigCache::storedConfigsChanged);
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QByteArrayLiteral("[ ]"));
+    }
+    QTRY_VERIFY_WITH_TIMEOUT(!changedSpy.isEmpty(), 10000);
+    QVERIFY(!cache->outputs(fileName).has_value());
+}
+
+QTEST_MAIN(TestPersistence)
+
+#include "persistencetest.moc"
@@ -7,6 +7,7 @@
 
 #include "../../kded/generator.h"
 #include "../../kded/output.h"
+#include "../../common/globals.h"
 
 #include <QObject>
 #include <QtTest>
@@ -504,6 +505,7 @@ void testScreenConfig::outputPreset()
     // Create the preset
     QTemporaryDir dataDir;
     qputenv("XDG_DATA_DIRS", dataDir.path().toUtf8());
+    Globals::resetPaths();
     QStandardPaths::standardLocations(QStandardPaths::DataLocation);
     auto presetOutput = defaultOutput->clone();
     presetOutput->setCurrentModeId(QStringLiteral("2"));
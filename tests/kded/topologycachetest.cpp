@@ -0,0 +1,174 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../kded/config.h"
+#include "../../kded/configcache.h"
+#include "../../kded/output.h"
+#include "../../kded/outputdatacache.h"
+#include "../../kded/outputidentitycache.h"
+#include "../../kded/topologycache.h"
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QStringBuilder>
+#include <QtTest>
+
+#include <KScreen/Config>
+#include <KScreen/Mode>
+#include <KScreen/Output>
+
+class TestTopologyCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testFind();
+    void testRenumberedOutputs();
+    void testGlobalDataChanged();
+    void testStoredConfigChanged();
+
+private:
+    KScreen::ConfigPtr createConfig() const;
+    TopologyCache::Key keyOf(const KScreen::ConfigPtr &config) const;
+    void writeConfigsFile(const QString &fileName);
+
+    QTemporaryDir m_temporaryDir;
+};
+
+void TestTopologyCache::initTestCase()
+{
+    qputenv("XDG_DATA_HOME", m_temporaryDir.path().toUtf8());
+    qputenv("KSCREEN_LOGGING", "false");
+}
+
+void TestTopologyCache::cleanup()
+{
+    OutputDataCache::destroy();
+    OutputIdentityCache::destroy();
+    ConfigCache::destroy();
+    QDir(Output::dirPath()).removeRecursively();
+    QDir(Config::configsDirPath()).removeRecursively();
+}
+
+KScreen::ConfigPtr TestTopologyCache::createConfig() const
+{
+    KScreen::ModePtr mode = KScreen::ModePtr::create();
+    mode->setId(QStringLiteral("MODE-0"));
+    mode->setSize(QSize(1920, 1080));
+    mode->setRefreshRate(60.0);
+
+    KScreen::ConfigPtr config = KScreen::ConfigPtr::create();
+    for (int id : {1, 2}) {
+        KScreen::OutputPtr output = KScreen::OutputPtr::create();
+        output->setId(id);
+        output->setName(QStringLiteral("OUTPUT-%1").arg(id));
+        output->setConnected(true);
+        output->setEnabled(true);
+        output->setModes({{mode->id(), mode}});
+        output->setCurrentModeId(mode->id());
+        output->setPos(QPoint((id - 1) * 1920, 0));
+        config->addOutput(output);
+    }
+    return config;
+}
+
+TopologyCache::Key TestTopologyCache::keyOf(const KScreen::ConfigPtr &config) const
+{
+    TopologyCache::Key key;
+    key.outputsHash = config->connectedOutputsHash();
+    return key;
+}
+
+void TestTopologyCache::writeConfigsFile(const QString &fileName)
+{
+    QFile file(Config::configsDirPath() % fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArrayLiteral("[]"));
+}
+
+void TestTopologyCache::testFind()
+{
+    const KScreen::ConfigPtr config = createConfig();
+    const TopologyCache::Key key = keyOf(config);
+    TopologyCache cache;
+    QVERIFY(!cache.find(key, config));
+    cache.insert(key, config);
+
+    const KScreen::ConfigPtr cached = cache.find(key, config);
+    QVERIFY(cached);
+    QVERIFY(cached != config);
+    QCOMPARE(cached->output(2)->pos(), config->output(2)->pos());
+
+    TopologyCache::Key lidClosedKey = key;
+    lidClosedKey.lidClosed = true;
+    QVERIFY(!cache.find(lidClosedKey, config));
+
+    cache.clear();
+    QVERIFY(!cache.find(key, config));
+}
+
+void TestTopologyCache::testRenumberedOutputs()
+{
+    const KScreen::ConfigPtr config = createConfig();
+    const TopologyCache::Key key = keyOf(config);
+    TopologyCache cache;
+    cache.insert(key, config);
+
+    // The same outputs under new ids do not fit anymore
+    const KScreen::ConfigPtr renumbered = config->clone();
+    const KScreen::OutputPtr output = renumbered->output(2);
+    renumbered->removeOutput(2);
+    output->setId(3);
+    renumbered->addOutput(output);
+    QVERIFY(!cache.find(key, renumbered));
+    QVERIFY(!cache.find(key, config));
+}
+
+void TestTopologyCache::testGlobalDataChanged()
+{
+    const KScreen::ConfigPtr config = createConfig();
+    const TopologyCache::Key key = keyOf(config);
+    TopologyCache cache;
+    cache.insert(key, config);
+    QVERIFY(cache.find(key, config));
+
+    // Someone else edits the global data of an output, its cached config is stale.
+    QVERIFY(QDir().mkpath(Output::dirPath()));
+    QFile file(Output::dirPath() % OutputIdentityCache::self()->hashMd5(config->output(2)));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArrayLiteral("{\"scale\": 2}"));
+    file.close();
+    QVERIFY(!cache.find(key, config));
+
+    // Cached again with the new data.
+    cache.insert(key, config);
+    QVERIFY(cache.find(key, config));
+}
+
+void TestTopologyCache::testStoredConfigChanged()
+{
+    QVERIFY(QDir().mkpath(Config::configsDirPath()));
+    const KScreen::ConfigPtr config = createConfig();
+    const TopologyCache::Key key = keyOf(config);
+    TopologyCache cache;
+    cache.insert(key, config);
+    QSignalSpy changedSpy(ConfigCache::self(), &ConfigCache::storedConfigsChanged);
+
+    // Usage bookkeeping and the stored configs of other outputs leave the entry alone.
+    writeConfigsFile(QStringLiteral(".usage"));
+    writeConfigsFile(QStringLiteral("other"));
+    QTRY_VERIFY_WITH_TIMEOUT(!changedSpy.isEmpty(), 10000);
+    QVERIFY(cache.find(key, config));
+
+    writeConfigsFile(key.outputsHash);
+    QTRY_VERIFY_WITH_TIMEOUT(!cache.find(key, config), 10000);
+}
+
+QTEST_MAIN(TestTopologyCache)
+
+#include "topologycachetest.moc"